@@ -4,6 +4,12 @@
  * For example, the struct could be represented as:
  * m_args = {{nnwcli::CT_STRING, "name", "Username for login"}, {nnwcli::CT_STRING, "password", "Password for login"}}
  * ... etc.
+ * Arguments of a custom type (see "custom_type.hpp") are CT_STRING_CUSTOM with the name of the type:
+ * {nnwcli::CT_STRING_CUSTOM, "target", "Where to connect", "endpoint"}
+ * and arguments matched by a pattern (see "pattern.hpp") are CT_PATTERN with the pattern:
+ * {nnwcli::CT_PATTERN, "host", "Host name", "[a-z0-9-]+(\\.[a-z0-9-]+)*"}
+ * Lists are declared with the type of their elements (see "list.hpp"):
+ * {nnwcli::list_of(nnwcli::CT_UINTEGER), "ports", "Ports to listen on"}
  * 
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -12,9 +18,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "argument_types.hpp"
+#include "custom_type.hpp"
 #include "globals.hpp"
+#include "pattern.hpp"
 
 
 namespace nnwcli
@@ -24,5 +33,21 @@ namespace nnwcli
         ArgumentTypes   m_type;
         std::string     m_name;
         std::string     m_description;
+        // name of the type in the TypeRegistry for CT_STRING_CUSTOM, the pattern for CT_PATTERN
+        std::string     m_parameter = {};
+        //
+        // Resolved from m_parameter when the command is registered.
+        //
+        CustomTypeId    m_custom_id = 0;
+        std::shared_ptr<const Pattern>
+                        m_pattern = nullptr;
+
+        // the custom type name or the pattern, otherwise the name of the argument type
+        const char* get_type_name() const
+        {
+            if((m_type == CT_STRING_CUSTOM || m_type == CT_PATTERN) && !m_parameter.empty())
+                return m_parameter.c_str();
+            return argtype_to_name(m_type);
+        }
     };
 }
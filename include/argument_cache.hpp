@@ -0,0 +1,53 @@
+/**
+ * argument_cache.hpp - Arguments of the running command, accessed by their names instead of in order.
+ *     const unsigned int port = context->arg<unsigned int>("port");
+ *     const std::string mode = context->arg<std::string>("mode", "auto");
+ * The name is resolved against the ArgumentDefinitions of the command, and only the requested argument
+ * is converted: the ones before it are skipped over without conversion, and where every argument starts
+ * is remembered, so the line is scanned once however the arguments are accessed.
+ * The converted values are kept until the end of the dispatch, and the parser is left where it was,
+ * so the arguments can still be parsed in order as well.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "custom_type.hpp"
+#include "globals.hpp"
+#include "parser/abstract_parser.hpp"
+
+
+namespace nnwcli
+{
+    // the command has no argument with such name
+    class DLL_PUBLIC unknown_argument : public cli_error
+    {
+    public:
+        std::string m_name;
+        unknown_argument(std::string name) : m_name(std::move(name)) {}
+        virtual const char* what() const noexcept override;
+    };
+
+    class DLL_PUBLIC ArgumentCache
+    {
+        // where the parser has to be for each argument, known up to the furthest one reached so far
+        std::vector<std::size_t>    m_starts;
+        // converted values by the index of the argument, the optional ones follow the mandatory ones
+        std::vector<CustomValue>    m_values;
+    public:
+        // forgets everything, the first argument starts at pos, keeps the memory
+        void reset(std::size_t pos);
+        /**
+         * Moves the parser to the index-th argument, skipping over the ones that weren't reached yet.
+         * False when the arguments end before it.
+         * */
+        bool seek(AbstractParser& parser, std::size_t index);
+        CustomValue& get_value(std::size_t index);
+    };
+}
@@ -9,6 +9,10 @@
  * argument line, making it impossible to have more arguments after.
  * It is marked as CT_FULL. No other arguments are to follow, and such argument type
  * should always be the last argument.
+ * CT_PATTERN is a limited string which has to match the pattern given by its ArgumentDefinition.
+ * CT_BLOB carries arbitrary octets, written as hex:..., b64:... or as they are, see "blob.hpp".
+ * CT_LIST is combined with the type of its elements, list_of(CT_UINTEGER) accepts 1,2,3 or [1,2,3],
+ * see "list.hpp".
  * 
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -43,10 +47,29 @@ namespace nnwcli
         CT_BOOL,
         // string with multiple words
         CT_FULL,
-        // parser is custom, and it is parsed as a string
+        // limited string matching a pattern, such as [a-z]+
+        CT_PATTERN,
+        // hex:00ff | b64:AP8= | \x00\xff
+        CT_BLOB,
+        // type registered in the TypeRegistry by the application, see "custom_type.hpp"
         CT_STRING_CUSTOM = 999,
+        // flag of a comma-separated list, combined with one of the types from CT_STRING to CT_BOOL
+        CT_LIST = 0x1000,
     };
 
+    constexpr ArgumentTypes list_of(const ArgumentTypes element_type)
+    {
+        return static_cast<ArgumentTypes>(CT_LIST | element_type);
+    }
+    constexpr bool is_list(const ArgumentTypes type)
+    {
+        return type & CT_LIST;
+    }
+    constexpr ArgumentTypes list_element_type(const ArgumentTypes type)
+    {
+        return static_cast<ArgumentTypes>(type & ~CT_LIST);
+    }
+
     /**
      * Returns textual representation of the enumerated argument type.
      * */
@@ -0,0 +1,165 @@
+/**
+ * async_context.hpp - Output written into file descriptors by a background thread.
+ * A command writing into a slow pipe would otherwise wait for the consumer inside execute().
+ * AsyncContext hands its output over to an AsyncStream, a lock-free single-producer ring
+ * (see "util/spsc_ring.hpp"), and returns right away. AsyncOutputWriter runs a thread
+ * that drains the rings of all its streams into their descriptors, waiting for the slow ones with poll().
+ * The output of a context reaches its descriptor in the order it was written.
+ *
+ * When the ring of a stream is full, its BackpressurePolicy decides what happens:
+ * the producer waits for the writer, the output is dropped, or the stream is disconnected.
+ * Descriptors are switched into the non-blocking mode while the writer has streams on them,
+ * and switched back once the last of those streams is gone. They are not closed by the writer.
+ * Only available on POSIX systems.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "buffered_context.hpp"
+#include "globals.hpp"
+#include "util/spsc_ring.hpp"
+
+
+namespace nnwcli
+{
+    class AsyncOutputWriter;
+
+    enum BackpressurePolicy : unsigned char
+    {
+        // the producer waits until the writer makes room
+        BP_BLOCK = 0,
+        // output that doesn't fit is dropped as a whole, see AsyncStream::get_dropped_bytes()
+        BP_DROP,
+        // the stream stops accepting output, as if the consumer has gone away
+        BP_DISCONNECT,
+    };
+
+    class DLL_PUBLIC AsyncStream
+    {
+        friend class AsyncOutputWriter;
+
+        AsyncOutputWriter*      m_writer;
+        SpscByteRing            m_ring;
+        int                     m_fd;
+        BackpressurePolicy      m_policy;
+        std::atomic<bool>       m_disconnected;
+        // errno of the failed write, 0 if disconnected by the policy or not at all
+        std::atomic<int>        m_errno;
+        std::atomic<std::uint64_t>
+                                m_dropped;
+        // a blocked producer sleeps on m_condition until the writer consumes something
+        std::mutex              m_mutex;
+        std::condition_variable m_condition;
+        std::atomic<bool>       m_waiting;
+    public:
+        AsyncStream(AsyncOutputWriter* writer, int fd, std::size_t capacity, BackpressurePolicy policy);
+
+        /**
+         * Queues the data for writing, called by a single producer thread only.
+         * Returns false if it was dropped or the stream is disconnected.
+         * */
+        bool push(const char* data, std::size_t n);
+        void disconnect(int error = 0);
+        /**
+         * Waits until the writer has written everything queued so far, or the stream got disconnected.
+         * Returns false on timeout.
+         * */
+        bool wait_drained(std::chrono::milliseconds timeout);
+
+        int get_fd() const;
+        BackpressurePolicy get_policy() const;
+        bool is_disconnected() const;
+        int get_errno() const;
+        std::uint64_t get_dropped_bytes() const;
+        // octets queued but not written yet, can be called from any thread
+        std::size_t get_pending() const;
+    };
+
+    class DLL_PUBLIC AsyncOutputWriter
+    {
+        friend class AsyncStream;
+
+        struct _Descriptor
+        {
+            // as they were before open(), -1 if they couldn't be read
+            int                 m_flags;
+            std::size_t         m_streams;
+        };
+
+        std::mutex              m_mutex;
+        std::vector<std::shared_ptr<AsyncStream>>
+                                m_streams;
+        // bumped on every change of m_streams, so the thread copies it only when needed
+        std::atomic<std::uint64_t>
+                                m_version;
+        // the descriptors of m_streams, by their numbers
+        std::map<int, _Descriptor>
+                                m_descriptors;
+        // self-pipe that interrupts poll()
+        int                     m_wake[2];
+        std::atomic<bool>       m_sleeping;
+        std::atomic<bool>       m_stopping;
+        std::chrono::milliseconds
+                                m_linger;
+        std::thread             m_thread;
+
+        void _run();
+        // writes what the descriptor accepts, returns true if something is left
+        bool _drain(AsyncStream& stream);
+        void _wake();
+        // takes the stream off the descriptor, the last one restores its blocking mode, called under m_mutex
+        void _release_descriptor(int fd);
+    public:
+        /**
+         * Starts the thread. On destruction, the queued output is still written for up to linger,
+         * after that it is discarded.
+         * */
+        AsyncOutputWriter(std::chrono::milliseconds linger = std::chrono::milliseconds(1000));
+        ~AsyncOutputWriter();
+        AsyncOutputWriter(const AsyncOutputWriter&) = delete;
+        AsyncOutputWriter& operator=(const AsyncOutputWriter&) = delete;
+
+        /**
+         * Registers a stream writing into fd. The writer keeps it until its output is written
+         * and nobody else holds it anymore.
+         * */
+        std::shared_ptr<AsyncStream> open(int fd, std::size_t capacity = 65536,
+                BackpressurePolicy policy = BP_BLOCK);
+        std::size_t get_stream_count();
+    };
+
+    /**
+     * BufferedContext that passes its output to an AsyncStream.
+     * Since the output is coalesced, a typical command costs a single push() at the end of the dispatch.
+     * */
+    class DLL_PUBLIC AsyncContext : public BufferedContext
+    {
+        std::shared_ptr<AsyncStream>    m_stream;
+    protected:
+        virtual void sink(const char* data, std::size_t n) override;
+    public:
+        AsyncContext(AsyncOutputWriter& writer, int fd, BackpressurePolicy policy = BP_BLOCK,
+                std::size_t capacity = 65536, std::size_t high_water = 65536);
+        virtual ~AsyncContext() = default;
+
+        const std::shared_ptr<AsyncStream>& get_stream() const;
+    };
+}
+
+#endif
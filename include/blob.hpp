@@ -0,0 +1,44 @@
+/**
+ * blob.hpp - Decoding of the CT_BLOB arguments, which carry arbitrary octets.
+ * A blob argument is written in one of the forms:
+ *     hex:00ff10       - two hexadecimal digits per octet, in either case
+ *     b64:AP8Q         - base64 of RFC 4648, the padding with = is optional
+ *     anything else    - the octets of the argument as they are, \x escapes included
+ * The decoders validate and convert 16 characters at a time (SSE2, when it is available)
+ * and finish the rest with the scalar code, the result is the same either way.
+ * Invalid characters, an odd number of hexadecimal digits or a truncated base64 group
+ * throw std::invalid_argument, so the errors are reported like for any other argument.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    //
+    // Without the prefixes. out has to have room for the decoded size, the number of octets written is returned.
+    //
+    DLL_PUBLIC std::size_t hex_decoded_size(std::string_view text);
+    DLL_PUBLIC std::size_t decode_hex(std::string_view text, std::uint8_t* out);
+    DLL_PUBLIC std::size_t base64_decoded_size(std::string_view text);
+    DLL_PUBLIC std::size_t decode_base64(std::string_view text, std::uint8_t* out);
+
+    //
+    // With the prefixes, as the blob arguments are written.
+    //
+    DLL_PUBLIC std::size_t blob_decoded_size(std::string_view text);
+    // std::out_of_range when the blob doesn't fit into capacity
+    DLL_PUBLIC std::size_t decode_blob(std::string_view text, std::uint8_t* buffer, std::size_t capacity);
+    // the previous contents of out are replaced
+    DLL_PUBLIC void decode_blob(std::string_view text, std::vector<std::uint8_t>& out);
+}
@@ -0,0 +1,144 @@
+/**
+ * broadcast_context.hpp - Output of a command mirrored to any amount of subscribers.
+ * BroadcastContext publishes its output into a BroadcastHub as immutable, reference-counted chunks.
+ * The hub keeps a single log of the chunks, and every subscriber only has a cursor into it,
+ * so publishing costs the same no matter how many subscribers there are, and the subscribers
+ * receive pointers to the shared chunks instead of copies.
+ *
+ * The log is trimmed once every subscriber has read past a chunk, and in any case when it grows
+ * past the limit of the hub. A subscriber that falls further behind than its own limit,
+ * or whose chunks were trimmed before it read them, is handled by its SubscriberPolicy.
+ * Subscribers can read from any thread, BroadcastHub is thread-safe.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "buffered_context.hpp"
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class BroadcastHub;
+
+    struct DLL_PUBLIC BroadcastChunk
+    {
+        std::uint64_t   m_sequence;
+        // amount of octets published before this chunk
+        std::uint64_t   m_offset;
+        std::string     m_data;
+    };
+
+    enum SubscriberPolicy : unsigned char
+    {
+        // the oldest pending chunks are skipped until the subscriber is within its limit
+        SP_DROP_OLDEST = 0,
+        // everything but the latest chunk is skipped, for the subscribers that only need the current state
+        SP_SKIP_TO_LATEST,
+        // the subscriber is disconnected and receives nothing more
+        SP_DISCONNECT,
+    };
+
+    class DLL_PUBLIC BroadcastSubscriber
+    {
+        friend class BroadcastHub;
+
+        std::shared_ptr<BroadcastHub>   m_hub;
+        // sequence and offset of the next chunk to read
+        std::uint64_t                   m_next;
+        std::uint64_t                   m_next_offset;
+        std::size_t                     m_max_pending;
+        SubscriberPolicy                m_policy;
+        bool                            m_disconnected;
+        std::uint64_t                   m_dropped_bytes;
+    public:
+        BroadcastSubscriber(std::shared_ptr<BroadcastHub> hub, std::size_t max_pending, SubscriberPolicy policy);
+        ~BroadcastSubscriber();
+        BroadcastSubscriber(const BroadcastSubscriber&) = delete;
+        BroadcastSubscriber& operator=(const BroadcastSubscriber&) = delete;
+
+        /**
+         * Appends the pending chunks to out, at most max_chunks of them unless it is 0.
+         * Returns how many were appended.
+         * */
+        std::size_t poll(std::vector<std::shared_ptr<const BroadcastChunk>>& out, std::size_t max_chunks = 0);
+        // waits until there is something to poll or the subscriber is disconnected, false on timeout
+        bool wait(std::chrono::milliseconds timeout);
+
+        std::size_t get_pending_bytes() const;
+        std::uint64_t get_dropped_bytes() const;
+        bool is_disconnected() const;
+        SubscriberPolicy get_policy() const;
+    };
+
+    /**
+     * Has to be owned by a std::shared_ptr, since the subscribers keep it alive.
+     * */
+    class DLL_PUBLIC BroadcastHub : public std::enable_shared_from_this<BroadcastHub>
+    {
+        friend class BroadcastSubscriber;
+
+        mutable std::mutex      m_mutex;
+        std::condition_variable m_condition;
+        std::deque<std::shared_ptr<const BroadcastChunk>>
+                                m_log;
+        std::uint64_t           m_next_sequence;
+        std::uint64_t           m_published_bytes;
+        std::size_t             m_log_bytes;
+        std::size_t             m_max_log_bytes;
+        std::vector<BroadcastSubscriber*>
+                                m_subscribers;
+        // publications since the last trim by the slowest cursor
+        unsigned int            m_since_trim;
+
+        void _trim_front();
+        void _trim_consumed();
+        // applies the policy of a subscriber that has fallen behind, called under m_mutex
+        void _catch_up(BroadcastSubscriber& subscriber);
+    public:
+        BroadcastHub(std::size_t max_log_bytes = 1 << 20);
+
+        /**
+         * The subscriber receives what is published from now on. Once it has more than max_pending
+         * octets waiting, the policy decides what happens.
+         * */
+        std::shared_ptr<BroadcastSubscriber> subscribe(std::size_t max_pending = 1 << 18,
+                SubscriberPolicy policy = SP_DROP_OLDEST);
+        void publish(const char* data, std::size_t n);
+        void publish(std::string data);
+
+        std::size_t get_subscriber_count() const;
+        // octets held by the log right now
+        std::size_t get_log_bytes() const;
+        std::uint64_t get_published_bytes() const;
+    };
+
+    /**
+     * BufferedContext publishing into a hub. With coalescing, the output of a dispatch becomes a single chunk.
+     * */
+    class DLL_PUBLIC BroadcastContext : public BufferedContext
+    {
+        std::shared_ptr<BroadcastHub>   m_hub;
+    protected:
+        virtual void sink(const char* data, std::size_t n) override;
+        virtual void sinkv(const OutputFragment* fragments, std::size_t count) override;
+    public:
+        BroadcastContext(std::shared_ptr<BroadcastHub> hub, std::size_t high_water = 65536);
+        virtual ~BroadcastContext() = default;
+
+        const std::shared_ptr<BroadcastHub>& get_hub() const;
+    };
+}
@@ -0,0 +1,128 @@
+/**
+ * buffered_context.hpp - Context that accumulates the output of a command in memory.
+ * Implementations only need to override sink(), which receives the accumulated output.
+ * The buffer is handed to sink() when it grows past the high-water mark, when flush() is called
+ * outside of a dispatch, and once at the end of every dispatch. flush() calls made by the command
+ * itself are coalesced into that last one, so a typical command costs a single sink() call.
+ * Coalescing can be turned off for the contexts that need to show the output as soon as it is flushed.
+ *
+ * In the OM_SCATTER output mode, the output is kept as a chain of fragments instead of a single buffer.
+ * Data passed to write_ref() (or streamed as nnwcli::ref()) is referenced by pointer, and only the rest
+ * is copied into the buffer, which then serves as an arena for the transient fragments.
+ * The chain is handed to sinkv() at once, which can pass it to writev() or a similar call,
+ * see "fd_context.hpp". Referenced data shorter than the copy threshold is copied anyway,
+ * since a fragment costs about as much as copying a few bytes. A flush() made while data is referenced
+ * drains the chain even when coalescing, as the referenced data is only promised to live until then.
+ * The buffer and the chain are allocated from the memory resource given to the constructor,
+ * by default the counting one, so they are accounted to the dispatch (see "memory_accounting.hpp").
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "context.hpp"
+#include "globals.hpp"
+#include "memory_accounting.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC BufferedContext : public CommandExecutorContext
+    {
+    public:
+        enum OutputMode : unsigned char
+        {
+            // everything is copied into a single buffer
+            OM_COPY = 0,
+            // referenced data is kept by pointer, see write_ref()
+            OM_SCATTER,
+        };
+        struct OutputFragment
+        {
+            const char*     m_data;
+            std::size_t     m_size;
+        };
+        // the chain is drained once it has this many fragments
+        static constexpr std::size_t max_fragments = 1024;
+    protected:
+        // a fragment with null m_data lies in m_buffer at m_offset
+        struct _Fragment
+        {
+            const char*     m_data;
+            std::size_t     m_offset;
+            std::size_t     m_size;
+        };
+
+        std::pmr::string
+                        m_buffer;
+        std::size_t     m_high_water;
+        bool            m_coalescing;
+        // dispatches may be nested when a command dispatches lines into its own context
+        unsigned int    m_dispatch_depth;
+        OutputMode      m_output_mode;
+        std::size_t     m_copy_threshold;
+        std::pmr::vector<_Fragment>
+                        m_fragments;
+        std::size_t     m_referenced_size;
+        // reused by drain() to pass the chain into sinkv()
+        std::pmr::vector<OutputFragment>
+                        m_chain;
+        // where the space given by output_reserve() starts
+        std::size_t     m_reserved;
+
+        /**
+         * Receives the buffered output. Called with a non-empty buffer only.
+         * It is the only method the implementations need to override.
+         * */
+        virtual void sink(const char* data, std::size_t n) = 0;
+        /**
+         * Receives the fragment chain in the OM_SCATTER mode.
+         * The default implementation calls sink() for every fragment.
+         * */
+        virtual void sinkv(const OutputFragment* fragments, std::size_t count);
+        // passes everything that is buffered into sink() or sinkv() and empties the buffer
+        void drain();
+        // accounts n octets just appended to m_buffer at offset
+        void _appended(std::size_t offset, std::size_t n);
+    public:
+        BufferedContext(std::size_t high_water = 65536,
+                std::pmr::memory_resource* resource = counting_memory_resource());
+        /**
+         * The output that is still buffered is lost, since sink() can't be called from here.
+         * The executor always drains the buffer at the end of a dispatch; other users should call flush().
+         * */
+        virtual ~BufferedContext() = default;
+
+        virtual void write(const char* data, std::size_t n) override;
+        virtual void write(const std::string& data) override;
+        virtual void write_ref(const char* data, std::size_t n) override;
+        virtual char* output_reserve(std::size_t n) override;
+        virtual void output_commit(std::size_t size) override;
+        virtual void vnprintf(const char* format, std::size_t n, va_list args) override;
+        virtual void vnprintf(const std::string& format, std::size_t n, va_list args) override;
+        virtual void flush() override;
+        virtual void begin_dispatch() override;
+        virtual void end_dispatch() override;
+
+        std::size_t get_high_water() const;
+        void set_high_water(std::size_t high_water);
+        bool is_coalescing() const;
+        // when disabled, every flush() reaches the sink right away
+        void set_coalescing(bool coalescing);
+        // includes the referenced data
+        std::size_t get_buffered_size() const;
+        OutputMode get_output_mode() const;
+        // drains the output buffered so far before switching
+        void set_output_mode(OutputMode mode);
+        std::size_t get_copy_threshold() const;
+        void set_copy_threshold(std::size_t threshold);
+    };
+}
@@ -11,6 +11,7 @@
 
 #include "command.hpp"
 #include "command_executor.hpp"
+#include "cursor.hpp"
 #include <algorithm>
 
 
@@ -27,11 +28,13 @@ public:
         m_description = "Show commands, their usage and their description. For showing information about a specific command, use /helpof command.";
     }
 
-    void show_help_entry_into(std::ostream& stream, Command* const command)
+    // works with std::ostream as well as with the context itself
+    template<typename Stream>
+    void show_help_entry_into(Stream& stream, Command* const command)
     {
         // the usage goes first
         command->format_usage_into(stream, command->get_name());
-        stream << ": " << command->get_description() << std::endl;
+        stream << ": " << nnwcli::ref(command->get_description()) << '\n';
     }
 
     virtual bool execute(nnwcli::CommandExecutorContext* const context, void* const data) override
@@ -45,26 +48,19 @@ public:
 
         parser->parse_unsigned_integer(page, false);
         page = std::clamp(page, 1U, maxpage);
-        std::size_t i = (page - 1) * m_elements_per_page;
-        const std::size_t end = page * m_elements_per_page;
-        std::stringstream ss;
-        ss << "--- Help (page " << page << " of " << maxpage << ") ---" << std::endl;
+        *context << "--- Help (page " << page << " of " << maxpage << ") ---\n";
         auto it = executor->get_command_iter();
+        auto cursor = nnwcli::make_cursor(it.first, it.second,
+                [this](nnwcli::CommandExecutorContext& ctx, const std::shared_ptr<Command>& command)
+                { show_help_entry_into(ctx, command.get()); });
 
-        // const iterators of set do not support linear advancing
-        std::advance(it.first, i);
-
-        for(; it.first != it.second && i < end; i++, it.first++)
-        {
-            show_help_entry_into(ss, it.first->get());
-        }
+        context->stream_page(cursor, page, m_elements_per_page);
 
         if(page < maxpage)
-            ss << "--- Next page: /" << context->get_alias() << " " << page + 1 << "---" << std::endl;
+            *context << "--- Next page: /" << context->get_alias() << ' ' << page + 1 << "---\n";
         else
-            ss << "--- This is the last page ---" << std::endl;
+            *context << "--- This is the last page ---\n";
 
-        *context << ss;
         context->flush();
 
         return true;
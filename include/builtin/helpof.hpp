@@ -24,8 +24,9 @@ public:
         m_description = "Show help for a specified command.";
     }
 
+    template<typename Stream>
     void write_aliases(
-            std::ostream& stream,
+            Stream& stream,
             std::map<std::string, std::shared_ptr<Command>>::const_iterator& start,
             std::map<std::string, std::shared_ptr<Command>>::const_iterator& end,
             Command* const cmd)
@@ -40,15 +41,16 @@ public:
             if(changed)
                 stream << ", ";
 
-            stream << start->first;
+            stream << nnwcli::ref(start->first);
             changed = true;
         }
         if(!changed)
             stream << "(none)";
     }
 
+    template<typename Stream>
     void write_arguments(
-            std::ostream& stream,
+            Stream& stream,
             std::size_t count,
             std::vector<nnwcli::ArgumentDefinition>::const_iterator& start,
             std::vector<nnwcli::ArgumentDefinition>::const_iterator& end)
@@ -58,11 +60,12 @@ public:
         {
             while(start != end)
             {
-                type_name = nnwcli::argtype_to_name(start->m_type);
-                stream << " - " << start->m_name << " (" << type_name << "): " << start->m_description;
+                type_name = start->get_type_name();
+                stream << " - " << nnwcli::ref(start->m_name) << " (" << nnwcli::ref(type_name) << "): "
+                       << nnwcli::ref(start->m_description);
 
                 if(++start != end)
-                    stream << std::endl;
+                    stream << '\n';
             }
         }
         else
@@ -71,10 +74,30 @@ public:
         }
     }
 
+    template<typename Stream>
+    void write_options(
+            Stream& stream,
+            std::vector<nnwcli::OptionDefinition>::const_iterator& start,
+            std::vector<nnwcli::OptionDefinition>::const_iterator& end)
+    {
+        while(start != end)
+        {
+            stream << " - ";
+            if(start->m_short)
+                stream << '-' << start->m_short << ", ";
+            stream << "--" << nnwcli::ref(start->m_name);
+            if(!start->is_flag())
+                stream << " (" << nnwcli::ref(start->get_type_name()) << ')';
+            stream << ": " << nnwcli::ref(start->m_description);
+
+            if(++start != end)
+                stream << '\n';
+        }
+    }
+
     virtual bool execute(nnwcli::CommandExecutorContext* const context, void* const data) override
     {
         std::string cmdname;
-        std::stringstream ss;
         std::shared_ptr<nnwcli::AbstractParser> const parser = context->get_parser();
         nnwcli::CommandExecutor* const executor = context->get_executor();
 
@@ -87,29 +110,35 @@ public:
         } 
         catch (const nnwcli::command_not_found& e)
         {
-            ss << "Command \"" << cmdname << "\" not found." << std::endl;
-            context->write(ss.str());
+            *context << "Command \"" << cmdname << "\" not found.\n";
             context->flush();
             return false;
         }
-        ss << "Description: " << cmd->get_description() << std::endl;
+        // the strings of the command are referenced, cmd keeps it alive until the flush below
+        *context << "Description: " << nnwcli::ref(cmd->get_description()) << '\n';
         auto alias_it = executor->get_alias_iter();
-        ss << "Aliases: ";
-        write_aliases(ss, alias_it.first, alias_it.second, cmd.get());
-        ss << std::endl;
+        *context << "Aliases: ";
+        write_aliases(*context, alias_it.first, alias_it.second, cmd.get());
+        *context << '\n';
 
-        cmd->format_usage_into(ss, cmdname);
-        ss << std::endl;
+        cmd->format_usage_into(*context, cmdname);
+        *context << '\n';
 
         // describe every argument
         auto arg_it = cmd->get_arg_iter();
-        ss << "Arguments:" << std::endl;
-        write_arguments(ss, cmd->get_args_count(), arg_it.first, arg_it.second);
-        ss << std::endl << "Optional arguments:" << std::endl;
+        *context << "Arguments:\n";
+        write_arguments(*context, cmd->get_args_count(), arg_it.first, arg_it.second);
+        *context << "\nOptional arguments:\n";
         auto optarg_it = cmd->get_optarg_iter();
-        write_arguments(ss, cmd->get_optargs_count(), optarg_it.first, optarg_it.second);
-        ss << std::endl;
-        *context << ss;
+        write_arguments(*context, cmd->get_optargs_count(), optarg_it.first, optarg_it.second);
+        *context << '\n';
+        if(cmd->get_options_count())
+        {
+            auto option_it = cmd->get_option_iter();
+            *context << "Options:\n";
+            write_options(*context, option_it.first, option_it.second);
+            *context << '\n';
+        }
         context->flush();
         
         return true;
@@ -0,0 +1,60 @@
+/**
+ * builtin/top.hpp - Out-of-the-box top command that lists the commands being executed right now.
+ * /top
+ * It runs concurrently with other commands, so it keeps working while another command hangs.
+ * 
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include "command.hpp"
+#include "command_executor.hpp"
+#include "format.hpp"
+#include <chrono>
+#include <functional>
+
+
+class TopCommand : public nnwcli::Command
+{
+public:
+    TopCommand()
+    {
+        m_name = "top";
+        m_description = "Show the commands that are being executed right now, the longest running first.";
+    }
+
+    virtual bool is_concurrent() const override
+    {
+        return true;
+    }
+
+    virtual bool execute(nnwcli::CommandExecutorContext* const context, void* const data) override
+    {
+        context->get_parser()->parse_finish();
+        nnwcli::CommandExecutor* const executor = context->get_executor();
+        const std::vector<nnwcli::InflightDispatch> inflight = executor->get_inflight();
+
+        *context << "--- " << inflight.size() << " command(s) in flight ---\n";
+        for(const nnwcli::InflightDispatch& entry : inflight)
+        {
+            const double seconds = std::chrono::duration<double>(entry.m_elapsed).count();
+
+            // the hash of a thread id is its native handle in the common implementations
+            *context << nnwcli::pad(nnwcli::fixed(seconds, 3), 10) << "s "
+                << "thread " << std::hash<std::thread::id>()(entry.m_thread)
+                << ", context " << entry.m_context_id
+                << ", output " << entry.m_output_bytes << " bytes: /" << entry.m_alias;
+            if(entry.m_alias != entry.m_command)
+                *context << " (" << entry.m_command << ')';
+            if(!entry.m_argline.empty())
+                *context << ' ' << entry.m_argline;
+            *context << '\n';
+        }
+
+        context->flush();
+        return true;
+    }
+};
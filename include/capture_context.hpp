@@ -0,0 +1,75 @@
+/**
+ * capture_context.hpp - Context that keeps the output of the commands for the code that called them.
+ *     auto capture = std::make_shared<nnwcli::CaptureContext>();
+ *     executor.dispatch_line_detailed("sum 1 2", capture);
+ *     std::string_view output = capture->view();
+ * The output is written into a chain of chunks that are never reallocated, each one larger than
+ * the previous, so writing costs no copies of what has been captured before.
+ * view() joins the chunks into one (only when there are several) and take() moves it out
+ * without copying. reset() keeps the largest chunk for the next capture,
+ * so a context reused for many invocations stops allocating after the first few.
+ * The chunks are allocated from the memory resource given to the constructor, by default the counting one,
+ * so the captured output is accounted to the dispatch that wrote it (see "memory_accounting.hpp").
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "context.hpp"
+#include "globals.hpp"
+#include "memory_accounting.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC CaptureContext : public CommandExecutorContext
+    {
+        // only the last chunk is written into, its capacity is never exceeded
+        std::pmr::vector<std::pmr::string>
+                                    m_chunks;
+        std::size_t                 m_chunk_size;
+        std::size_t                 m_size;
+        // where the space given by output_reserve() starts in the last chunk
+        std::size_t                 m_reserved;
+
+        // the last chunk, with room for at least n more octets
+        std::pmr::string& _room_for(std::size_t n);
+        void _join();
+    public:
+        // chunk_size is the capacity of the first chunk, the following ones double it
+        CaptureContext(std::size_t chunk_size = 4096,
+                std::pmr::memory_resource* resource = counting_memory_resource());
+        virtual ~CaptureContext() = default;
+
+        virtual void write(const char* data, std::size_t n) override;
+        virtual void write(const std::string& data) override;
+        virtual char* output_reserve(std::size_t n) override;
+        virtual void output_commit(std::size_t size) override;
+        virtual void vnprintf(const char* format, std::size_t n, va_list args) override;
+        virtual void vnprintf(const std::string& format, std::size_t n, va_list args) override;
+        // the output stays captured
+        virtual void flush() override;
+
+        // the captured output as a single contiguous view, valid until the next write or reset()
+        std::string_view view();
+        // moves the captured output out and resets the context, the string keeps the memory resource
+        std::pmr::string take();
+        // forgets the output, keeping the largest chunk allocated
+        void reset();
+        std::size_t size() const;
+        bool empty() const;
+
+        // the chunks can be passed to writev() as they are, without joining them
+        std::size_t get_chunk_count() const;
+        std::string_view get_chunk(std::size_t index) const;
+    };
+}
@@ -6,7 +6,7 @@
  *     context->get_parser()
  *
  * which has a bunch of methods for extracting specific type of arguments.
- * Arguments should be extracted sequentally.
+ * Arguments should be extracted sequentally, the options (see "option.hpp") by their names.
  * m_name should always be initialized.
  * 
  * License: The MIT License.
@@ -20,7 +20,9 @@
 #include <vector>
 #include "argument.hpp"
 #include "context.hpp"
+#include "custom_type_registry.hpp"
 #include "globals.hpp"
+#include "option.hpp"
 
 
 namespace nnwcli
@@ -33,6 +35,9 @@ namespace nnwcli
         std::vector<ArgumentDefinition> 
                                         m_optargs;
         std::string                     m_description;
+        std::vector<OptionDefinition>   m_options;
+    private:
+        OptionIndex                     m_option_index;
     public:
         virtual ~Command() = default;
         /**
@@ -50,14 +55,31 @@ namespace nnwcli
         virtual std::vector<std::string> tab_complete(CommandExecutorContext& context,
                 void* data) const;
 
+        /**
+         * By default, the executor runs one command at a time.
+         * Commands returning true are executed right away, in parallel with the others,
+         * and therefore must be thread-safe.
+         * */
+        virtual bool is_concurrent() const;
+
         const std::string& get_name() const;
         const std::string& get_description() const;
         std::size_t get_args_count() const;
         std::size_t get_optargs_count() const;
+        std::size_t get_options_count() const;
+        // built by resolve_argument_types()
+        const OptionIndex& get_option_index() const;
         void set_name(const std::string name);
         void set_name(const char* name);
         void set_description(const std::string description);
         void set_description(const char* description);
+        /**
+         * Looks up the ids of the custom argument types, compiles the patterns and indexes the options,
+         * called when the command is registered.
+         * Throws unknown_custom_type when a type isn't registered, pattern_error when a pattern is invalid,
+         * std::invalid_argument when an option is declared twice.
+         * */
+        void resolve_argument_types(const TypeRegistry& registry);
 
         std::pair<std::vector<ArgumentDefinition>::const_iterator,
                   std::vector<ArgumentDefinition>::const_iterator>
@@ -65,6 +87,9 @@ namespace nnwcli
         std::pair<std::vector<ArgumentDefinition>::const_iterator,
                   std::vector<ArgumentDefinition>::const_iterator>
             get_optarg_iter() const;
+        std::pair<std::vector<OptionDefinition>::const_iterator,
+                  std::vector<OptionDefinition>::const_iterator>
+            get_option_iter() const;
         // needed to construct a sorted set of commands
         const bool operator< (const Command&& other) const;
 
@@ -82,5 +107,19 @@ namespace nnwcli
                 const std::string description_before = ": ",
                 const std::string description_after = ""
                 ) const;
+        // writes straight into the context, without a stringstream
+        void format_usage_into(
+                CommandExecutorContext& context,
+                const std::string alias,
+                const std::string command_prefix = "/",
+                const std::string arg_before = "(",
+                const std::string arg_before_type = " <",
+                const std::string arg_after_type = ">",
+                const std::string arg_after = ")",
+                const std::string optarg_before = "[",
+                const std::string optarg_after = "]",
+                const std::string description_before = ": ",
+                const std::string description_after = ""
+                ) const;
     };
 }
@@ -4,9 +4,29 @@
  * dispatch_line is used to possibly invoke the command and populate the output into the context.
  * In order to execute commands, it needs an implemented context factory, which
  * is an instance of std::function, returning objects of class extending CommandExecutorContext.
- * Right now, the custom type registry is not implemented and is WIP feature.
+ * Custom argument types are registered into get_type_registry() before the commands that use them.
+ * Optionally, every dispatched line can be recorded into a CommandJournal (see "journal.hpp"),
+ * which can be replayed later against the same or a newer set of commands.
+ * For every command, the executor keeps CommandStatistics: dispatch count, time spent
+ * and the memory allocated by its dispatches (see "memory_accounting.hpp").
  *
- * Method dispatch_line() is thread-safe.
+ * Method dispatch_line() is thread-safe. The executor is locked only while the command is resolved,
+ * and commands are executed one at a time under a separate, recursive lock, which lets a command
+ * dispatch other lines itself. Commands that report is_concurrent() skip that lock, so that they
+ * can run while another command hangs; the lines in flight are listed by get_inflight().
+ * watch() runs a line periodically and sends only the changes of its output, see "watch.hpp".
+ * invoke() calls a command from C++ with typed values, without rendering them into a line:
+ *     auto sum = executor.resolve("sum");
+ *     executor.invoke(sum, 1, 2);
+ * The values are pushed into a PlaceholderParser, their argument types are picked at compile time.
+ * Invocations are reported, counted and listed in flight like the dispatched lines,
+ * but they are not recorded into the journal, which only holds the text lines. The arguments encoded
+ * by machine clients are dispatched the same way by dispatch_binary() (see "parser/binary_parser.hpp").
+ * With set_encoding_policy(), the dispatched lines are checked to be valid UTF-8 in a single vectorized pass,
+ * and either rejected as DR_SYNTAX_ERROR or repaired before they are parsed; the same policy applies
+ * to the arguments which escapes make invalid. By default the lines are passed through unchecked.
+ * With set_case_insensitive(), the command names are matched regardless of their case: the names are folded
+ * once when they are registered, and the name of a dispatched line is folded while its end is searched for.
  * 
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -15,17 +35,88 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <string_view>
+#include <vector>
 #include "command.hpp"
 #include "context.hpp"
+#include "custom_type_registry.hpp"
+#include "inflight.hpp"
+#include "memory_accounting.hpp"
+#include "parser/placeholder_parser.hpp"
+#include "util/utf8.hpp"
 
 
 namespace nnwcli
 {
+    class CommandJournal;
+    class CommandWatch;
+
+    /**
+     * Outcome of a single dispatch, more detailed than the boolean returned by dispatch_line.
+     * */
+    enum DispatchResult : unsigned char
+    {
+        // command executed and returned true
+        DR_SUCCESS = 0,
+        // command executed and returned false
+        DR_FAILURE,
+        // no command or alias with such name
+        DR_UNKNOWN_COMMAND,
+        // the argument line could not be tokenized
+        DR_SYNTAX_ERROR,
+        // one of the arguments was missing, superfluous or invalid
+        DR_ARGUMENT_ERROR,
+    };
+
+    // how CommandWatch finds out what has changed in the output
+    enum WatchDiffMode : unsigned char
+    {
+        WD_LINES = 0,
+        WD_CHUNKS,
+    };
+
+    struct DLL_PUBLIC CommandStatistics
+    {
+        std::size_t                 m_dispatches = 0;
+        // dispatches which did not end with DR_SUCCESS
+        std::size_t                 m_failures = 0;
+        std::chrono::nanoseconds    m_total_time = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds    m_max_time = std::chrono::nanoseconds::zero();
+        std::size_t                 m_allocations = 0;
+        std::size_t                 m_allocated_bytes = 0;
+        // the most bytes allocated by a single dispatch
+        std::size_t                 m_max_allocated_bytes = 0;
+        // the most bytes held at once by a single dispatch
+        std::int64_t                m_peak_bytes = 0;
+
+        void add(DispatchResult result, std::chrono::nanoseconds time, const AllocationCounters& counters);
+    };
+
+    /**
+     * Command resolved once by CommandExecutor::resolve(), so that invoke() skips the lookup of the alias.
+     * Keeps the command alive even when it is unregistered. An empty handle invokes nothing
+     * and is reported as an unknown command.
+     * */
+    struct DLL_PUBLIC CommandHandle
+    {
+        std::shared_ptr<Command>    m_command;
+        // name the command was resolved by
+        std::string                 m_alias;
+
+        explicit operator bool() const
+        {
+            return static_cast<bool>(m_command);
+        }
+    };
+
     class command_not_found : public cli_error
     {
         virtual const char* what() const noexcept override
@@ -42,11 +133,41 @@ namespace nnwcli
         std::map<std::string,
                  std::shared_ptr<Command>> 
                                                 m_aliases;
+        // case-folded aliases to the aliases as they are registered, the first one of those folded alike
+        std::map<std::string, std::string>      m_folded_aliases;
+        std::atomic<bool>                       m_case_insensitive;
         std::function<std::shared_ptr<CommandExecutorContext>()>
                                                 m_context_factory;
         std::shared_ptr<CommandExecutorContext> m_latest_context;
+        std::shared_ptr<CommandJournal>         m_journal;
+        std::atomic<EncodingPolicy>             m_encoding_policy;
+        std::atomic<std::uint64_t>              m_next_context_id;
+        // keyed by Command::get_name()
+        std::map<std::string, CommandStatistics>
+                                                m_statistics;
+        CommandStatistics                       m_total_statistics;
+        InflightTable                           m_inflight;
+        std::recursive_mutex                    m_execute_mutex;
+        TypeRegistry                            m_type_registry;
+
+        // the name to look up, case-folded in the case-insensitive mode
+        std::string _lookup_name(const std::string& name) const;
+        std::map<std::string, std::shared_ptr<Command>>::iterator _find_alias(const std::string& lookup_name);
+        void _rebuild_folded_aliases();
+        // executes the command and reports the argument errors into the context
+        DispatchResult _execute(const std::shared_ptr<Command>& cmd,
+                const std::string& cmdname, const std::string& argline,
+                const std::shared_ptr<CommandExecutorContext>& ctx, void* data);
+        /**
+         * Shared by dispatch_line, invoke and dispatch_binary: takes the context, looks cmdname up when lookup is set,
+         * executes the command and keeps the statistics. Without a parser, an ArglineParser of argline is used.
+         * line is appended to the journal when it is not nullptr.
+         * */
+        DispatchResult _dispatch(const std::string& cmdname, std::shared_ptr<Command> cmd, bool lookup,
+                const std::string& argline, std::shared_ptr<AbstractParser> parser,
+                std::shared_ptr<CommandExecutorContext> context_override, void* data, const std::string* line);
     public:
-        std::mutex m_mutex;
+        mutable std::mutex m_mutex;
 
         CommandExecutor();
         virtual ~CommandExecutor() = default;
@@ -60,6 +181,41 @@ namespace nnwcli
         const std::shared_ptr<CommandExecutorContext>& get_latest_context();
         void set_factory(const std::function<std::shared_ptr<CommandExecutorContext>()>& factory);
 
+        /**
+         * Every line dispatched after this call is appended to the journal.
+         * Passing nullptr stops the recording. When the journal can't be written, the dispatch
+         * still succeeds, but the journal is detached and get_journal() returns nullptr from then on.
+         * */
+        void set_journal(std::shared_ptr<CommandJournal> journal);
+        std::shared_ptr<CommandJournal> get_journal() const;
+        void set_encoding_policy(EncodingPolicy policy);
+        EncodingPolicy get_encoding_policy() const;
+        /**
+         * Command names are looked up regardless of their case, also by resolve() and get_command().
+         * While it is set, a command or an alias which differs from an existing one only in case isn't registered.
+         * */
+        void set_case_insensitive(bool case_insensitive);
+        bool is_case_insensitive() const;
+
+        /**
+         * Allocations made through this resource during a dispatch are accounted
+         * to the dispatched command, even when the library is built without NNWCLI_ALLOCATION_HOOK.
+         * It is counting_memory_resource(), so the memory can outlive the executor.
+         * */
+        std::pmr::memory_resource* get_memory_resource();
+        // commands being executed right now, the longest running first
+        std::vector<InflightDispatch> get_inflight() const;
+        // name can be an alias, throws command_not_found
+        CommandStatistics get_statistics(const std::string name);
+        // all dispatches, including those of unknown commands
+        CommandStatistics get_total_statistics() const;
+        // copy of the statistics of every command that was dispatched, by the command names
+        std::map<std::string, CommandStatistics> get_all_statistics() const;
+        void reset_statistics();
+
+        TypeRegistry& get_type_registry();
+
+        // throws unknown_custom_type when the command uses a type that isn't registered
         bool register_command(const std::string name, std::shared_ptr<Command> command);
         bool register_command(std::shared_ptr<Command> command);
         bool add_alias(const std::string target, const std::string src);
@@ -68,7 +224,65 @@ namespace nnwcli
 
         bool dispatch_line(const std::string line,
                 std::shared_ptr<CommandExecutorContext> context_override = nullptr, void* data = nullptr);
+        // same as dispatch_line, but tells exactly how the dispatch went
+        DispatchResult dispatch_line_detailed(const std::string& line,
+                std::shared_ptr<CommandExecutorContext> context_override = nullptr, void* data = nullptr);
+        // the handle is empty when there is no command or alias with such name
+        CommandHandle resolve(const std::string& name);
+        /**
+         * Executes the command with the values as its arguments, in a context made by the factory.
+         * Returns what the same command would return for a dispatched line.
+         * */
+        template<typename... Args>
+        DispatchResult invoke(const CommandHandle& command, const Args&... args)
+        {
+            return invoke_in(nullptr, command, args...);
+        }
+        template<typename... Args>
+        DispatchResult invoke(const std::string& name, const Args&... args)
+        {
+            return invoke_in(nullptr, name, args...);
+        }
+        // same as invoke, with the output written into the context
+        template<typename... Args>
+        DispatchResult invoke_in(std::shared_ptr<CommandExecutorContext> context,
+                const CommandHandle& command, const Args&... args)
+        {
+            auto parser = std::make_shared<PlaceholderParser>();
+
+            (parser->push(args), ...);
+            return _dispatch(command.m_alias, command.m_command, false, std::string(), std::move(parser),
+                    std::move(context), nullptr, nullptr);
+        }
+        template<typename... Args>
+        DispatchResult invoke_in(std::shared_ptr<CommandExecutorContext> context,
+                const std::string& name, const Args&... args)
+        {
+            auto parser = std::make_shared<PlaceholderParser>();
+
+            (parser->push(args), ...);
+            return _dispatch(_lookup_name(name), nullptr, true, std::string(), std::move(parser),
+                    std::move(context), nullptr, nullptr);
+        }
+        /**
+         * Executes the command with the arguments encoded by BinaryArgumentEncoder (see "parser/binary_parser.hpp"),
+         * in the context or in one made by the factory. data is borrowed only until it returns.
+         * Malformed arguments are reported into the context as DR_SYNTAX_ERROR.
+         * */
+        DispatchResult dispatch_binary(const CommandHandle& command, std::string_view data,
+                std::shared_ptr<CommandExecutorContext> context = nullptr);
+        DispatchResult dispatch_binary(const std::string& name, std::string_view data,
+                std::shared_ptr<CommandExecutorContext> context = nullptr);
+        /**
+         * Dispatches the line into an internal buffer every interval, and writes the differences
+         * from the previous run into the context. The watch runs until it is stopped or destroyed.
+         * */
+        std::shared_ptr<CommandWatch> watch(const std::string& line,
+                std::shared_ptr<CommandExecutorContext> context, std::chrono::milliseconds interval,
+                WatchDiffMode mode = WD_LINES);
         virtual void handle_unknown_command(const std::string cmd, std::shared_ptr<CommandExecutorContext> context);
+        // the line isn't valid UTF-8 and the policy is EP_REJECT
+        virtual void handle_invalid_encoding(const std::string& line, std::shared_ptr<CommandExecutorContext> context);
 
         std::shared_ptr<Command>& get_command(const std::string name);
         std::size_t get_command_count() const;
@@ -5,6 +5,15 @@
  *     write(), nprintf() and << operator for strings to show the output somewhere.
  * Since the most popular choice is either a pipe or standard output, the output
  * needs to be flushed before it can be used.
+ * Numbers, characters and booleans can be streamed with << as well, they are converted with std::to_chars
+ * right into the output of the context, without any locale or stream state. For the hexadecimal and padded
+ * output, see the manipulators in "format.hpp".
+ * Commands that produce data rather than prose can write it as records with begin_record(), field()
+ * and end_record(), rendered by the serializer of the context, see "record.hpp".
+ * Large results can be streamed row by row from a cursor with stream(), see "cursor.hpp".
+ * Arguments of the running command can be accessed by their names with arg(), see "argument_cache.hpp".
+ * Implementations should report the size of everything they write with count_output(),
+ * so that the executor can tell how much output a running command has produced.
  *
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -12,12 +21,22 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdarg>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <sstream>
 #include <string>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include "argument_cache.hpp"
+#include "cursor.hpp"
+#include "memory_accounting.hpp"
 #include "parser/abstract_parser.hpp"
+#include "record.hpp"
 #include "globals.hpp"
 
 
@@ -26,6 +45,31 @@ namespace nnwcli
     class Command;
     class CommandExecutor;
 
+    /**
+     * Output that stays alive until the next flush() of the context, or until the end of the dispatch
+     * when the command doesn't flush: string literals, the descriptions of the commands, or the strings
+     * of the command itself if it calls flush() before they are gone.
+     * Contexts may keep the pointer instead of copying the data, see write_ref().
+     * */
+    struct DLL_PUBLIC OutputRef
+    {
+        const char*     m_data;
+        std::size_t     m_size;
+    };
+    inline OutputRef ref(const char* data)
+    {
+        return {data, std::strlen(data)};
+    }
+    inline OutputRef ref(const std::string& data)
+    {
+        return {data.data(), data.size()};
+    }
+    // so that the formatting shared with std::ostream can reference the data as well
+    inline std::ostream& operator<<(std::ostream& stream, const OutputRef& data)
+    {
+        return stream.write(data.m_data, data.m_size);
+    }
+
     /** Base class for execution context.
      *  Used when executing commands, showing output.
      *  Features like command output must be implemented. */
@@ -39,6 +83,22 @@ namespace nnwcli
         std::weak_ptr<Command>
                             m_command;
         std::string         m_alias;
+        // identifies the session the context belongs to, 0 means not assigned yet
+        std::uint64_t       m_id = 0;
+        // set by the executor while the command is running, see "inflight.hpp"
+        std::atomic<std::uint64_t>*
+                            m_output_counter = nullptr;
+        // created on the first record if not set
+        std::shared_ptr<RecordSerializer>
+                            m_serializer;
+        bool                m_in_record = false;
+        // reset by set_command()
+        ArgumentCache       m_arguments;
+
+        // to be called by write() implementations
+        void count_output(std::size_t n);
+        // throws unknown_argument, required is set for the mandatory arguments
+        const ArgumentDefinition& _find_argument(std::string_view name, std::size_t& index, bool& required) const;
     public:
         virtual ~CommandExecutorContext();
         CommandExecutorContext();
@@ -60,24 +120,171 @@ namespace nnwcli
         const std::string get_alias() const;
         void set_command(std::string alias, std::shared_ptr<Command>& command);
 
+        /**
+         * Converted value of the argument of the running command, parsed on the first access.
+         * Returns nullptr when an optional argument isn't given, throws not_enough_arguments
+         * for a missing mandatory one, or the usual parser errors for a wrong value.
+         * */
+        template<typename T>
+        const T* find_arg(const std::string_view name)
+        {
+            std::size_t index;
+            bool required;
+            const ArgumentDefinition& definition = _find_argument(name, index, required);
+            CustomValue& cached = m_arguments.get_value(index);
+
+            if(const T* const value = cached.get_if<T>())
+                return value;
+
+            AbstractParser& parser = *m_parser;
+            const std::size_t pos = parser.get_pos(), argument_pos = parser.get_argument_pos();
+            bool found;
+            try
+            {
+                found = m_arguments.seek(parser, index) && parser.parse_as(definition, cached.emplace<T>(), required);
+                if(!found && required)
+                    throw not_enough_arguments();
+            }
+            catch(...)
+            {
+                // the parser stays at the wrong argument, so that the error is reported for it
+                cached.reset();
+                throw;
+            }
+            parser.set_pos(pos);
+            parser.set_argument_pos(argument_pos);
+            if(!found)
+            {
+                cached.reset();
+                return nullptr;
+            }
+            return cached.get_if<T>();
+        }
+        template<typename T>
+        const T& arg(const std::string_view name)
+        {
+            const T* const value = find_arg<T>(name);
+            if(!value)
+                throw not_enough_arguments();
+            return *value;
+        }
+        // fallback when an optional argument isn't given
+        template<typename T>
+        T arg(const std::string_view name, T fallback)
+        {
+            const T* const value = find_arg<T>(name);
+            return value ? *value : fallback;
+        }
+
+        std::uint64_t get_id() const;
+        void set_id(std::uint64_t id);
+        void set_output_counter(std::atomic<std::uint64_t>* counter);
+
+        // the contexts are allocated from counting_memory_resource(), so they are accounted to the dispatch
         template<typename Child>
         static inline std::function<std::shared_ptr<Child>()>
             create_factory()
         {
-            return std::function<std::shared_ptr<Child>()>([](){ return std::make_shared<Child>(); });
+            return std::function<std::shared_ptr<Child>()>([]()
+            {
+                return std::allocate_shared<Child>(std::pmr::polymorphic_allocator<Child>(counting_memory_resource()));
+            });
         }
 
         virtual void write(const char* data, std::size_t n) = 0;
         virtual void write(const std::string& data) = 0;
+        /**
+         * Same as write(), but the data is promised to stay alive until the next flush(),
+         * or the end of the dispatch, so it doesn't have to be copied (see OutputRef).
+         * The default implementation simply calls write().
+         * */
+        virtual void write_ref(const char* data, std::size_t n);
+        /**
+         * Gives n writable octets at the end of the output, or nullptr if the context can't write in place.
+         * The first size octets become the output after output_commit(size), where size <= n.
+         * No other output method may be called in between.
+         * Used by nnwcli::format() (see "format.hpp") to avoid intermediate buffers.
+         * */
+        virtual char* output_reserve(std::size_t n);
+        virtual void output_commit(std::size_t size);
+        // printf-like formatting, kept for compatibility; nnwcli::format() is type-checked and faster
         virtual void vnprintf(const char* format, std::size_t n, va_list args) = 0;
         virtual void vnprintf(const std::string& format, std::size_t n, va_list args) = 0;
         virtual void flush() = 0;
+        /**
+         * Called by the executor around every dispatch into this context, the default does nothing.
+         * end_dispatch() is called even if the command couldn't be found or has thrown.
+         * */
+        virtual void begin_dispatch();
+        virtual void end_dispatch();
         void nprintf(const char* format, std::size_t n, ...);
         void nprintf(const std::string& format, std::size_t n, ...);
 
-        /** Show the output, used by the commands. */
+        /**
+         * Show the output, used by the commands.
+         * Strings are copied, unless they are streamed as nnwcli::ref(), which passes them to write_ref().
+         * */
         virtual CommandExecutorContext& operator<<(const char* data);
         virtual CommandExecutorContext& operator<<(const std::string& data);
         virtual CommandExecutorContext& operator<<(const std::stringstream& data);
+        CommandExecutorContext& operator<<(const OutputRef& data);
+        CommandExecutorContext& operator<<(std::string_view data);
+        CommandExecutorContext& operator<<(char value);
+        CommandExecutorContext& operator<<(bool value);
+        // signed and unsigned char are shown as numbers, unlike char
+        CommandExecutorContext& operator<<(signed char value);
+        CommandExecutorContext& operator<<(unsigned char value);
+        CommandExecutorContext& operator<<(short value);
+        CommandExecutorContext& operator<<(unsigned short value);
+        CommandExecutorContext& operator<<(int value);
+        CommandExecutorContext& operator<<(unsigned int value);
+        CommandExecutorContext& operator<<(long value);
+        CommandExecutorContext& operator<<(unsigned long value);
+        CommandExecutorContext& operator<<(long long value);
+        CommandExecutorContext& operator<<(unsigned long long value);
+        // the shortest representation that reads back into the same value
+        CommandExecutorContext& operator<<(float value);
+        CommandExecutorContext& operator<<(double value);
+        CommandExecutorContext& operator<<(long double value);
+
+        // stream() calls flush() after this many rows, so that plain contexts don't hold all of them
+        static constexpr std::size_t stream_flush_rows = 256;
+        /**
+         * Writes the rows of the cursor until it is exhausted, or until max_rows rows were written
+         * if max_rows is not 0.
+         * */
+        StreamResult stream(OutputCursor& cursor, std::size_t max_rows = 0);
+        // skips the pages before the page-th one (counted from 1) and writes page_rows rows
+        StreamResult stream_page(OutputCursor& cursor, std::size_t page, std::size_t page_rows);
+
+        // the text serializer is used unless another one is set
+        const std::shared_ptr<RecordSerializer>& get_serializer();
+        void set_serializer(std::shared_ptr<RecordSerializer> serializer);
+        void set_record_format(RecordFormat format);
+        /**
+         * Records can't be nested. begin_record() inside of an unfinished record throws record_error
+         * and discards the unfinished one, so a command that has thrown in the middle of a record
+         * doesn't break the context for the next one.
+         * */
+        CommandExecutorContext& begin_record(std::string_view name = std::string_view());
+        CommandExecutorContext& write_field(std::string_view key, const RecordValue& value);
+        CommandExecutorContext& end_record();
+        // integers keep their signedness, char is a single character string
+        template<typename T>
+        CommandExecutorContext& field(const std::string_view key, const T& value)
+        {
+            if constexpr(std::is_same_v<T, bool>)
+                return write_field(key, RecordValue(value));
+            else if constexpr(std::is_same_v<T, char>)
+                return write_field(key, RecordValue(std::string_view(&value, 1)));
+            else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+                return write_field(key, RecordValue(static_cast<std::int64_t>(value)));
+            else if constexpr(std::is_integral_v<T>)
+                return write_field(key, RecordValue(static_cast<std::uint64_t>(value)));
+            else if constexpr(std::is_floating_point_v<T>)
+                return write_field(key, RecordValue(static_cast<double>(value)));
+            else
+                return write_field(key, RecordValue(std::string_view(value)));
+        }
     };
 }
@@ -0,0 +1,103 @@
+/**
+ * cursor.hpp - Streaming output of large command results.
+ * Instead of rendering the whole result at once, a command gives the context a cursor,
+ * and the context pulls the rows one by one:
+ *     auto cursor = nnwcli::make_cursor(rows.cbegin(), rows.cend(),
+ *         [](nnwcli::CommandExecutorContext& ctx, const Row& row) { ctx << row.m_name << '\n'; });
+ *     context->stream(cursor);
+ * The rows go through the usual output methods, so the memory used by a command is bounded by the
+ * context: BufferedContext drains its buffer into the sink every time it reaches the high-water mark,
+ * and with AsyncContext the cursor is advanced only as fast as the consumer reads.
+ * stream_page() shows a single page of the rows and tells whether there are more; the cursor
+ * stays where the page ended, so the next page can be streamed from the same cursor later.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class CommandExecutorContext;
+
+    class DLL_PUBLIC OutputCursor
+    {
+    public:
+        virtual ~OutputCursor() = default;
+
+        virtual bool at_end() const = 0;
+        // writes the next row, only called while at_end() is false
+        virtual void next(CommandExecutorContext& ctx) = 0;
+        /**
+         * Moves past at most rows rows without showing them, returns how many were skipped.
+         * The default implementation renders them into a context that discards everything,
+         * cursors that can seek should override it.
+         * */
+        virtual std::size_t skip(std::size_t rows);
+    };
+
+    struct DLL_PUBLIC StreamResult
+    {
+        std::size_t     m_rows;
+        // true if the cursor has nothing left to show
+        bool            m_exhausted;
+    };
+
+    /**
+     * Cursor over [begin, end) of any forward iterators, every element is written by writer(ctx, element).
+     * Skipping costs std::advance() only.
+     * */
+    template<typename Iterator, typename Writer>
+    class RangeCursor : public OutputCursor
+    {
+        Iterator    m_it;
+        Iterator    m_end;
+        Writer      m_writer;
+    public:
+        RangeCursor(Iterator begin, Iterator end, Writer writer) :
+            m_it(std::move(begin)), m_end(std::move(end)), m_writer(std::move(writer)) {}
+
+        virtual bool at_end() const override
+        {
+            return m_it == m_end;
+        }
+        virtual void next(CommandExecutorContext& ctx) override
+        {
+            m_writer(ctx, *m_it);
+            ++m_it;
+        }
+        virtual std::size_t skip(const std::size_t rows) override
+        {
+            using category = typename std::iterator_traits<Iterator>::iterator_category;
+
+            if constexpr(std::is_base_of_v<std::random_access_iterator_tag, category>)
+            {
+                const std::size_t left = static_cast<std::size_t>(m_end - m_it);
+                const std::size_t skipped = rows < left ? rows : left;
+                m_it += skipped;
+                return skipped;
+            }
+            else
+            {
+                std::size_t skipped = 0;
+                for(; skipped < rows && m_it != m_end; skipped++)
+                    ++m_it;
+                return skipped;
+            }
+        }
+    };
+    template<typename Iterator, typename Writer>
+    inline RangeCursor<Iterator, Writer> make_cursor(Iterator begin, Iterator end, Writer writer)
+    {
+        return RangeCursor<Iterator, Writer>(std::move(begin), std::move(end), std::move(writer));
+    }
+}
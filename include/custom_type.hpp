@@ -1,17 +1,205 @@
-#pragma once
+/**
+ * custom_type.hpp - Argument types defined by the application, in addition to "argument_types.hpp".
+ * A custom type converts the textual form of an argument into a value of any C++ type:
+ *     executor.get_type_registry().register_custom_type<Endpoint>("endpoint", parse_endpoint);
+ * and the commands declare such arguments as CT_STRING_CUSTOM with the name of the type:
+ *     m_args = {{nnwcli::CT_STRING_CUSTOM, "target", "Where to connect", "endpoint"}};
+ * The name is resolved into a CustomTypeId once, when the command is registered, and the parsers
+ * fill a CustomValue with it:
+ *     nnwcli::CustomValue target;
+ *     parser->parse_custom(target, m_args[0].m_custom_id);
+ *     const Endpoint& endpoint = target.get<Endpoint>();
+ * CustomValue keeps values of up to inline_size octets within itself, larger ones are allocated.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
 
 
-#include "globals.hpp"
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include "globals.hpp"
+
+
 namespace nnwcli
 {
+    // 0 is never assigned to a type
+    using CustomTypeId = std::uint32_t;
+
+    // CustomValue::get() of a type the value doesn't hold
+    class DLL_PUBLIC bad_custom_value : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override;
+    };
+
+    class DLL_PUBLIC CustomValue
+    {
+    public:
+        // enough for a std::string with a few more members
+        static constexpr std::size_t inline_size = 6 * sizeof(void*);
+    private:
+        // one instance per stored C++ type, its address identifies the type
+        struct _Operations
+        {
+            bool    m_inline;
+            void    (*m_destroy)(void* value);
+            void    (*m_copy)(CustomValue& destination, const void* value);
+            // only for the inline values, the allocated ones are moved by their pointer
+            void    (*m_move)(void* destination, void* value);
+        };
+
+        template<typename T>
+        static constexpr bool _fits = sizeof(T) <= inline_size && alignof(T) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible_v<T>;
+
+        template<typename T>
+        static const _Operations* _operations_of()
+        {
+            static const _Operations operations = {
+                _fits<T>,
+                [](void* const value)
+                {
+                    if constexpr(_fits<T>)
+                        static_cast<T*>(value)->~T();
+                    else
+                        delete static_cast<T*>(value);
+                },
+                [](CustomValue& destination, const void* const value)
+                {
+                    destination.emplace<T>(*static_cast<const T*>(value));
+                },
+                [](void* const destination, void* const value)
+                {
+                    if constexpr(_fits<T>)
+                    {
+                        new(destination) T(std::move(*static_cast<T*>(value)));
+                        static_cast<T*>(value)->~T();
+                    }
+                },
+            };
+            return &operations;
+        }
+
+        alignas(std::max_align_t) unsigned char m_storage[inline_size];
+        void*                                   m_heap;
+        const _Operations*                      m_operations;
+        CustomTypeId                            m_type;
+
+        void* _value();
+        const void* _value() const;
+        void _take(CustomValue& other) noexcept;
+    public:
+        CustomValue() noexcept;
+        CustomValue(const CustomValue& other);
+        CustomValue(CustomValue&& other) noexcept;
+        CustomValue& operator=(const CustomValue& other);
+        CustomValue& operator=(CustomValue&& other) noexcept;
+        ~CustomValue();
+
+        // destroys the held value and constructs a new one, the type id is kept
+        template<typename T, typename... Args>
+        T& emplace(Args&&... args)
+        {
+            static_assert(std::is_copy_constructible_v<T>, "custom values have to be copyable");
+            const CustomTypeId type = m_type;
+
+            reset();
+            if constexpr(_fits<T>)
+            {
+                T* const value = new(m_storage) T(std::forward<Args>(args)...);
+                m_operations = _operations_of<T>();
+                m_type = type;
+                return *value;
+            }
+            else
+            {
+                T* const value = new T(std::forward<Args>(args)...);
+                m_heap = value;
+                m_operations = _operations_of<T>();
+                m_type = type;
+                return *value;
+            }
+        }
+        template<typename T>
+        T* get_if()
+        {
+            return m_operations == _operations_of<T>() ? static_cast<T*>(_value()) : nullptr;
+        }
+        template<typename T>
+        const T* get_if() const
+        {
+            return m_operations == _operations_of<T>() ? static_cast<const T*>(_value()) : nullptr;
+        }
+        // throws bad_custom_value
+        template<typename T>
+        T& get()
+        {
+            T* const value = get_if<T>();
+            if(!value)
+                throw bad_custom_value();
+            return *value;
+        }
+        template<typename T>
+        const T& get() const
+        {
+            const T* const value = get_if<T>();
+            if(!value)
+                throw bad_custom_value();
+            return *value;
+        }
+
+        void reset();
+        bool empty() const;
+        // whether the value is stored within the object, without an allocation
+        bool is_inline() const;
+        CustomTypeId get_type() const;
+        void set_type(CustomTypeId type);
+    };
+
     class DLL_PUBLIC AbstractCustomType
     {
     public:
-        virtual AbstractCustomType& parse_from_string(const std::string& raw) = 0;
-        virtual std::pair<AbstractCustomType&, bool> parse_from_argline(
-                const std::string& raw, std::size_t start = 0, bool required = true) = 0;
-        virtual std::string serialize() = 0;
+        virtual ~AbstractCustomType() = default;
+        /**
+         * Converts the textual form of an argument into out.
+         * std::invalid_argument and std::out_of_range are reported like for the other argument types.
+         * */
+        virtual void parse(std::string_view text, CustomValue& out) const = 0;
+        // the textual form of a value, which parse() accepts back
+        virtual void serialize(const CustomValue& value, std::string& out) const = 0;
+    };
+
+    /**
+     * Custom type of the values of T, made of a parsing and an optional serializing function.
+     * */
+    template<typename T>
+    class CustomType : public AbstractCustomType
+    {
+        std::function<T(std::string_view)>              m_parse;
+        std::function<void(const T&, std::string&)>     m_serialize;
+    public:
+        CustomType(std::function<T(std::string_view)> parse,
+                std::function<void(const T&, std::string&)> serialize = nullptr) :
+            m_parse(std::move(parse)), m_serialize(std::move(serialize)) {}
+
+        virtual void parse(const std::string_view text, CustomValue& out) const override
+        {
+            out.emplace<T>(m_parse(text));
+        }
+        virtual void serialize(const CustomValue& value, std::string& out) const override
+        {
+            if(!m_serialize)
+                throw bad_custom_value();
+            m_serialize(value.get<T>(), out);
+        }
     };
 }
@@ -1,23 +1,50 @@
+/**
+ * custom_type_registry.hpp - Registry of the custom argument types, owned by CommandExecutor.
+ * Types are registered by name and receive a CustomTypeId, which stays valid until the type
+ * is unregistered, so commands look their types up by name only once, when they are registered.
+ * Types should be registered before the commands using them; the registry itself is not locked.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
 #pragma once
 
-#include "custom_type.hpp"
-#include "globals.hpp"
+#include <cstddef>
 #include <functional>
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "custom_type.hpp"
+#include "globals.hpp"
 
 
 namespace nnwcli
 {
     class DLL_PUBLIC TypeRegistry
     {
-        std::map<const std::string,
-            std::function<AbstractCustomType(std::string)>&> m_custom_types;
-
+        std::unordered_map<std::string, CustomTypeId>       m_ids;
+        // indexed by id - 1, unregistered types leave nullptr so that no id is reused
+        std::vector<std::shared_ptr<AbstractCustomType>>    m_types;
     public:
-        void register_custom_type(const std::string name, std::function<AbstractCustomType(std::string)>& constructor);
-        void unregister_custom_type(const std::string name);
+        // returns 0 when the name is already taken
+        CustomTypeId register_custom_type(const std::string& name, std::shared_ptr<AbstractCustomType> type);
+        template<typename T>
+        CustomTypeId register_custom_type(const std::string& name, std::function<T(std::string_view)> parse,
+                std::function<void(const T&, std::string&)> serialize = nullptr)
+        {
+            return register_custom_type(name, std::make_shared<CustomType<T>>(std::move(parse), std::move(serialize)));
+        }
+        bool unregister_custom_type(const std::string& name);
 
-        std::function<AbstractCustomType(std::string)>& get_type_constructor(const std::string name);
+        // returns 0 when there is no such type
+        CustomTypeId find(const std::string& name) const;
+        // throws unknown_custom_type
+        const AbstractCustomType& get(CustomTypeId id) const;
+        std::size_t get_count() const;
     };
 }
@@ -0,0 +1,50 @@
+/**
+ * fd_context.hpp - BufferedContext writing into a POSIX file descriptor.
+ * By default it works in the OM_SCATTER output mode, so the whole output of a command,
+ * including the referenced fragments, is written with a single writev() call.
+ * Partial writes and interrupted calls are retried, other errors throw output_error.
+ * The descriptor is not closed by the context.
+ * Only available on POSIX systems.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cstddef>
+#include "buffered_context.hpp"
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC output_error : public cli_error
+    {
+    public:
+        int m_errno;
+        output_error(const int error)
+        {
+            m_errno = error;
+        }
+        virtual const char* what() const noexcept override;
+    };
+
+    class DLL_PUBLIC FileDescriptorContext : public BufferedContext
+    {
+        int m_fd;
+    protected:
+        virtual void sink(const char* data, std::size_t n) override;
+        virtual void sinkv(const OutputFragment* fragments, std::size_t count) override;
+    public:
+        FileDescriptorContext(int fd, OutputMode mode = OM_SCATTER, std::size_t high_water = 65536);
+        virtual ~FileDescriptorContext() = default;
+
+        int get_fd() const;
+    };
+}
+
+#endif
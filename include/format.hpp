@@ -0,0 +1,421 @@
+/**
+ * format.hpp - Type-checked formatting of the command output, a replacement for nprintf().
+ *     nnwcli::format(context, NNWCLI_FORMAT("Result: {}\n"), arg1 + arg2);
+ * Every "{}" in the format string is replaced by the next argument, "{{" and "}}" stand for literal braces.
+ * The format string is parsed by the constexpr constructor of FormatString, which also checks
+ * that the amount of placeholders matches the amount of arguments. With NNWCLI_FORMAT() the FormatString
+ * is a constexpr variable, so it is parsed once, by the compiler, and a wrong format string is a compile error.
+ * A plain literal works as well: when compiled as C++20 the constructor is consteval, so the same holds,
+ * but in C++17 the literal is parsed on every call and a wrong one throws format_error.
+ * Numbers are written with std::to_chars, right into the buffer of the context when it allows that
+ * (see CommandExecutorContext::output_reserve), without locale or va_list overhead.
+ * Any type with a format_value(CommandExecutorContext&, const T&) overload can be formatted.
+ * The hex(), pad(), left() and fixed() manipulators work both here and with the << operator of the context.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "context.hpp"
+#include "globals.hpp"
+#include "util/utf8.hpp"
+
+#if defined(__cpp_consteval)
+  #define NNWCLI_CONSTEVAL consteval
+#else
+  #define NNWCLI_CONSTEVAL constexpr
+#endif
+
+// format string parsed and checked at compile time, also in C++17, see nnwcli::format()
+#define NNWCLI_FORMAT(literal) ([]() \
+    { \
+        struct _Source \
+        { \
+            static constexpr auto& data() \
+            { \
+                return literal; \
+            } \
+        }; \
+        return ::nnwcli::FormatLiteral<_Source>(); \
+    }())
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC format_error : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override
+        {
+            return "format string does not match the arguments";
+        }
+    };
+
+    namespace detail
+    {
+        template<typename T>
+        struct identity
+        {
+            using type = T;
+        };
+        template<typename T>
+        using identity_t = typename identity<T>::type;
+
+        /**
+         * Calls writer(char* out) -> char* end with at least N octets available,
+         * either in the output of the context, or on the stack.
+         * */
+        template<std::size_t N, typename Writer>
+        inline void write_in_place(CommandExecutorContext& ctx, Writer&& writer)
+        {
+            char* const out = ctx.output_reserve(N);
+
+            if(out)
+            {
+                ctx.output_commit(writer(out) - out);
+                return;
+            }
+            char buffer[N];
+            ctx.write(buffer, writer(buffer) - buffer);
+        }
+    }
+
+    //
+    // Value writers, found by the formatting functions through overload resolution.
+    //
+
+    inline void format_value(CommandExecutorContext& ctx, const char* const value)
+    {
+        ctx.write(value, std::strlen(value));
+    }
+    inline void format_value(CommandExecutorContext& ctx, const std::string& value)
+    {
+        ctx.write(value);
+    }
+    inline void format_value(CommandExecutorContext& ctx, const std::string_view value)
+    {
+        ctx << value;
+    }
+    template<typename T>
+    inline std::enable_if_t<std::is_arithmetic_v<T>>
+    format_value(CommandExecutorContext& ctx, const T value)
+    {
+        ctx << value;
+    }
+
+    //
+    // Manipulators, usable both with << and as the arguments of format():
+    //     *context << nnwcli::hex(address, 8) << ' ' << nnwcli::pad(count, 6) << '\n';
+    //
+
+    template<typename T>
+    struct HexValue
+    {
+        T               m_value;
+        unsigned int    m_width;
+        bool            m_uppercase;
+    };
+    template<typename T>
+    struct PaddedValue
+    {
+        const T&        m_value;
+        unsigned int    m_width;
+        char            m_fill;
+        bool            m_left;
+    };
+    struct FixedValue
+    {
+        double          m_value;
+        int             m_precision;
+    };
+
+    /**
+     * Integer in hexadecimal, without the "0x" prefix, zero-padded to width digits.
+     * Negative values are shown as their unsigned counterparts.
+     * */
+    template<typename T>
+    inline HexValue<std::make_unsigned_t<T>> hex(const T value, const unsigned int width = 0,
+            const bool uppercase = false)
+    {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "hex() takes an integer");
+        return {static_cast<std::make_unsigned_t<T>>(value), width, uppercase};
+    }
+    /**
+     * Value aligned to the right within width characters. Numbers padded with '0' keep their sign in front.
+     * Takes numbers, characters, strings and the other manipulators; the value must outlive the expression.
+     * Strings are measured in UTF-8 code points, so that the columns of non-ASCII text line up.
+     * */
+    template<typename T>
+    inline PaddedValue<T> pad(const T& value, const unsigned int width, const char fill = ' ')
+    {
+        return {value, width, fill, false};
+    }
+    // value aligned to the left within width characters
+    template<typename T>
+    inline PaddedValue<T> left(const T& value, const unsigned int width, const char fill = ' ')
+    {
+        return {value, width, fill, true};
+    }
+    // floating point number with a fixed amount of digits after the point
+    inline FixedValue fixed(const double value, const int precision)
+    {
+        return {value, precision};
+    }
+
+    namespace detail
+    {
+        // largest output of a manipulated number: 128 octets of the fixed notation are enough for 1e100
+        constexpr std::size_t rendered_size = 128;
+
+        template<typename T>
+        inline char* render(char* const out, const HexValue<T>& value)
+        {
+            char* end = std::to_chars(out, out + rendered_size, value.m_value, 16).ptr;
+            const std::size_t digits = end - out;
+
+            if(digits < value.m_width && value.m_width <= rendered_size)
+            {
+                const std::size_t shift = value.m_width - digits;
+                std::memmove(out + shift, out, digits);
+                std::memset(out, '0', shift);
+                end += shift;
+            }
+            if(value.m_uppercase)
+            {
+                for(char* it = out; it != end; it++)
+                {
+                    if(*it >= 'a' && *it <= 'f')
+                        *it -= 'a' - 'A';
+                }
+            }
+            return end;
+        }
+        inline char* render(char* const out, const FixedValue& value)
+        {
+            const std::to_chars_result result = std::to_chars(out, out + rendered_size, value.m_value,
+                    std::chars_format::fixed, value.m_precision);
+
+            if(result.ec != std::errc())
+                return std::to_chars(out, out + rendered_size, value.m_value, std::chars_format::scientific).ptr;
+            return result.ptr;
+        }
+        template<typename T>
+        inline std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, char*>
+        render(char* const out, const T value)
+        {
+            if constexpr(std::is_same_v<T, char>)
+            {
+                *out = value;
+                return out + 1;
+            }
+            else
+                return std::to_chars(out, out + rendered_size, value).ptr;
+        }
+
+        // the padded value is either rendered into a buffer, or it is a string already
+        template<typename T>
+        inline std::string_view as_view(const T& value, char* const buffer)
+        {
+            if constexpr(std::is_convertible_v<const T&, std::string_view>)
+                return value;
+            else if constexpr(std::is_same_v<T, bool>)
+                return value ? "true" : "false";
+            else
+                return std::string_view(buffer, render(buffer, value) - buffer);
+        }
+
+        inline void write_fill(CommandExecutorContext& ctx, std::size_t n, const char fill)
+        {
+            char chunk[64];
+
+            std::memset(chunk, fill, n < sizeof(chunk) ? n : sizeof(chunk));
+            while(n)
+            {
+                const std::size_t part = n < sizeof(chunk) ? n : sizeof(chunk);
+                ctx.write(chunk, part);
+                n -= part;
+            }
+        }
+    }
+
+    template<typename T>
+    inline void format_value(CommandExecutorContext& ctx, const HexValue<T>& value)
+    {
+        detail::write_in_place<detail::rendered_size>(ctx, [&value](char* const out)
+                { return detail::render(out, value); });
+    }
+    inline void format_value(CommandExecutorContext& ctx, const FixedValue& value)
+    {
+        detail::write_in_place<detail::rendered_size>(ctx, [&value](char* const out)
+                { return detail::render(out, value); });
+    }
+    template<typename T>
+    inline void format_value(CommandExecutorContext& ctx, const PaddedValue<T>& value)
+    {
+        char buffer[detail::rendered_size];
+        std::string_view view = detail::as_view(value.m_value, buffer);
+        std::size_t width = view.size();
+        if constexpr(std::is_convertible_v<const T&, std::string_view>)
+            width = utf8_count_codepoints(view);
+        const std::size_t fill = width < value.m_width ? value.m_width - width : 0;
+
+        if(value.m_left)
+        {
+            ctx << view;
+            detail::write_fill(ctx, fill, value.m_fill);
+            return;
+        }
+        if constexpr(std::is_arithmetic_v<T>)
+        {
+            // zeros go between the sign and the digits
+            if(value.m_fill == '0' && !view.empty() && view.front() == '-')
+            {
+                ctx << '-';
+                view.remove_prefix(1);
+            }
+        }
+        detail::write_fill(ctx, fill, value.m_fill);
+        ctx << view;
+    }
+
+    template<typename T>
+    inline CommandExecutorContext& operator<<(CommandExecutorContext& ctx, const HexValue<T>& value)
+    {
+        format_value(ctx, value);
+        return ctx;
+    }
+    template<typename T>
+    inline CommandExecutorContext& operator<<(CommandExecutorContext& ctx, const PaddedValue<T>& value)
+    {
+        format_value(ctx, value);
+        return ctx;
+    }
+    inline CommandExecutorContext& operator<<(CommandExecutorContext& ctx, const FixedValue& value)
+    {
+        format_value(ctx, value);
+        return ctx;
+    }
+
+    template<typename T, typename = void>
+    struct is_formattable : std::false_type {};
+    template<typename T>
+    struct is_formattable<T, std::void_t<decltype(
+        format_value(std::declval<CommandExecutorContext&>(), std::declval<const T&>()))>> : std::true_type {};
+
+    template<typename... Args>
+    class FormatString
+    {
+        static_assert((is_formattable<Args>::value && ...),
+                "no format_value() overload for one of the arguments");
+
+        const char*     m_data;
+        std::size_t     m_size;
+        // positions of the "{}" placeholders, one extra to avoid an empty array
+        std::size_t     m_placeholders[sizeof...(Args) + 1];
+        bool            m_escaped;
+
+        void _write_literal(CommandExecutorContext& ctx, std::size_t start, const std::size_t end) const
+        {
+            if(!m_escaped)
+            {
+                if(end > start)
+                    ctx.write(m_data + start, end - start);
+                return;
+            }
+            // doubled braces turn into a single one
+            for(std::size_t i = start; i < end; i++)
+            {
+                if(m_data[i] != '{' && m_data[i] != '}')
+                    continue;
+                ctx.write(m_data + start, i + 1 - start);
+                start = ++i + 1;
+            }
+            if(end > start)
+                ctx.write(m_data + start, end - start);
+        }
+    public:
+        template<std::size_t N>
+        NNWCLI_CONSTEVAL FormatString(const char (&format)[N]) :
+            m_data(format), m_size(N - 1), m_placeholders{}, m_escaped(false)
+        {
+            std::size_t count = 0;
+
+            for(std::size_t i = 0; i < m_size; i++)
+            {
+                const bool last = i + 1 >= m_size;
+
+                if(format[i] == '{' && !last && format[i + 1] == '}')
+                {
+                    if(count >= sizeof...(Args))
+                        throw format_error();
+                    m_placeholders[count++] = i++;
+                }
+                else if((format[i] == '{' || format[i] == '}') && !last && format[i + 1] == format[i])
+                {
+                    m_escaped = true;
+                    i++;
+                }
+                else if(format[i] == '{' || format[i] == '}')
+                {
+                    // unmatched brace or a format specification, which is not supported
+                    throw format_error();
+                }
+            }
+            if(count != sizeof...(Args))
+                throw format_error();
+        }
+
+        void write(CommandExecutorContext& ctx, const Args&... args) const
+        {
+            std::size_t pos = 0, i = 0;
+
+            ((_write_literal(ctx, pos, m_placeholders[i]),
+              format_value(ctx, args),
+              pos = m_placeholders[i++] + 2), ...);
+            _write_literal(ctx, pos, m_size);
+        }
+    };
+
+    // the format string given to NNWCLI_FORMAT(), Source::data() is the literal
+    template<typename Source>
+    struct FormatLiteral {};
+
+    /**
+     * Writes the formatted arguments into the context.
+     * The format string is checked against the types of the arguments, see FormatString.
+     * */
+    template<typename Source, typename... Args>
+    inline void format(CommandExecutorContext& ctx, FormatLiteral<Source>, const Args&... args)
+    {
+        // a format_error thrown by the constructor makes this initializer not constant, a compile error
+        static constexpr FormatString<Args...> fmt(Source::data());
+        fmt.write(ctx, args...);
+    }
+    template<typename Source, typename... Args>
+    inline void format(CommandExecutorContext* const ctx, const FormatLiteral<Source> literal, const Args&... args)
+    {
+        format(*ctx, literal, args...);
+    }
+    template<typename... Args>
+    inline void format(CommandExecutorContext& ctx,
+            const detail::identity_t<FormatString<Args...>>& fmt, const Args&... args)
+    {
+        fmt.write(ctx, args...);
+    }
+    template<typename... Args>
+    inline void format(CommandExecutorContext* const ctx,
+            const detail::identity_t<FormatString<Args...>>& fmt, const Args&... args)
+    {
+        fmt.write(*ctx, args...);
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * inflight.hpp - Lock-free table of the dispatches that are being executed right now.
+ * The CommandExecutor claims a slot for every executed command and releases it afterwards,
+ * so the table can be inspected from any thread while commands are running, even if they hang.
+ * Slots are written only by the thread that claimed them and are read with a sequence lock:
+ * a reader copies the slot and discards the copy if the sequence number changed meanwhile.
+ * When every slot is busy, the dispatch simply isn't tracked.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    struct DLL_PUBLIC InflightDispatch
+    {
+        std::thread::id                         m_thread;
+        std::uint64_t                           m_context_id;
+        std::string                             m_command;
+        std::string                             m_alias;
+        // only the beginning of the argument line is kept
+        std::string                             m_argline;
+        std::chrono::steady_clock::time_point   m_started;
+        std::chrono::nanoseconds                m_elapsed;
+        std::uint64_t                           m_output_bytes;
+    };
+
+    class DLL_PUBLIC InflightTable
+    {
+    public:
+        static constexpr std::size_t slot_count = 64;
+        static constexpr std::size_t name_size = 32;
+        static constexpr std::size_t argline_size = 64;
+
+        class Slot
+        {
+            friend class InflightTable;
+
+            std::atomic<bool>           m_busy;
+            // odd while the slot is being changed
+            std::atomic<std::uint32_t>  m_sequence;
+            std::thread::id             m_thread;
+            std::uint64_t               m_context_id;
+            std::chrono::steady_clock::time_point
+                                        m_started;
+            unsigned char               m_command_size, m_alias_size, m_argline_size;
+            char                        m_command[name_size];
+            char                        m_alias[name_size];
+            char                        m_argline[argline_size];
+        public:
+            // updated by the context while the command writes its output
+            std::atomic<std::uint64_t>  m_output_bytes;
+
+            Slot();
+        };
+    private:
+        Slot                    m_slots[slot_count];
+        std::atomic<std::size_t>
+                                m_untracked;
+    public:
+        InflightTable();
+        InflightTable(InflightTable&) = delete;
+        InflightTable(InflightTable&&) = delete;
+
+        // returns nullptr when every slot is busy
+        Slot* acquire(const std::string& command, const std::string& alias,
+                const std::string& argline, std::uint64_t context_id);
+        void release(Slot* slot);
+
+        // dispatches in flight, the longest running first
+        std::vector<InflightDispatch> snapshot() const;
+        // how many dispatches were not tracked because the table was full
+        std::size_t get_untracked_count() const;
+    };
+}
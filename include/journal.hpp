@@ -0,0 +1,170 @@
+/**
+ * journal.hpp - Recording and replaying of the dispatched command lines.
+ * CommandJournal is attached to the CommandExecutor with set_journal(), and from then on
+ * every dispatched line is appended to a compact binary file, together with the time it was dispatched,
+ * how long it took, which thread dispatched it, the id of the context and the result.
+ * Records are accumulated in memory and written in batches, one write call per batch.
+ *
+ * JournalReplayer reads such a file back and dispatches every line again, at the original pace,
+ * N times faster, or as fast as possible. Lines recorded by different threads are replayed
+ * by different threads as well, so the concurrency of the recorded workload is preserved.
+ * The replay report tells how many lines ended up with a different DispatchResult than recorded,
+ * and which ones threw instead.
+ *
+ * File format, varints are LEB128 (see "util/varint.hpp"):
+ *     header: "NNWJ", version octet, varint of microseconds since the epoch when the journal was opened
+ *     record: zigzag varint offset from the header time in microseconds, varint duration in microseconds,
+ *             varint thread index, varint context id, result octet, varint line size, line octets
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "command_executor.hpp"
+#include "context.hpp"
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC journal_io_error : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override;
+    };
+    class DLL_PUBLIC journal_format_error : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override;
+    };
+
+    struct DLL_PUBLIC JournalRecord
+    {
+        // microseconds since the journal was opened
+        std::int64_t    m_offset;
+        // microseconds spent in the dispatch
+        std::uint64_t   m_duration;
+        // index of the dispatching thread, in order of appearance
+        std::uint64_t   m_thread;
+        std::uint64_t   m_context_id;
+        DispatchResult  m_result;
+        std::string     m_line;
+    };
+
+    class DLL_PUBLIC CommandJournal
+    {
+        std::mutex      m_mutex;
+        std::FILE*      m_file;
+        std::string     m_buffer;
+        std::size_t     m_batch_size;
+        std::chrono::system_clock::time_point
+                        m_opened;
+        std::map<std::thread::id, std::uint64_t>
+                        m_threads;
+
+        void _write_batch();
+    public:
+        /**
+         * Creates (or truncates) the journal file. Throws journal_io_error if it can't be opened.
+         * Records are written once at least batch_size octets are accumulated.
+         * */
+        CommandJournal(const std::string& path, std::size_t batch_size = 65536);
+        CommandJournal(CommandJournal&) = delete;
+        CommandJournal(CommandJournal&&) = delete;
+        // writes the remaining records and closes the file, the records that can't be written are lost
+        virtual ~CommandJournal();
+
+        void append(const std::string& line, std::uint64_t context_id, DispatchResult result,
+                std::chrono::system_clock::time_point started,
+                std::chrono::system_clock::time_point finished);
+        // writes the accumulated records, regardless of the batch size
+        void flush();
+        /**
+         * Writes the remaining records and closes the file, throws journal_io_error if they can't be written.
+         * The file is closed either way, and the records appended afterwards can't be written.
+         * */
+        void close();
+
+        std::size_t get_batch_size() const;
+        void set_batch_size(std::size_t batch_size);
+    };
+
+    class DLL_PUBLIC JournalReader
+    {
+        std::FILE*      m_file;
+        std::string     m_buffer;
+        std::size_t     m_pos;
+        std::chrono::system_clock::time_point
+                        m_opened;
+
+        // makes sure that at least n octets are available past m_pos, returns false at the end of file
+        bool _fill(std::size_t n);
+        std::uint64_t _read_varint();
+    public:
+        // throws journal_io_error if the file can't be opened, journal_format_error if it is not a journal
+        JournalReader(const std::string& path);
+        JournalReader(JournalReader&) = delete;
+        JournalReader(JournalReader&&) = delete;
+        virtual ~JournalReader();
+
+        /**
+         * Reads the next record, returns false when there are no records left.
+         * Throws journal_format_error when the record is truncated or malformed.
+         * */
+        bool read(JournalRecord& out);
+        std::chrono::system_clock::time_point get_open_time() const;
+    };
+
+    struct DLL_PUBLIC ReplayReport
+    {
+        std::size_t                 m_records = 0;
+        // indexes of the records which had a different result when replayed
+        std::vector<std::size_t>    m_mismatches;
+        // indexes of the records whose dispatch threw, they are not counted as mismatches
+        std::vector<std::size_t>    m_errors;
+        std::chrono::nanoseconds    m_elapsed = std::chrono::nanoseconds::zero();
+    };
+
+    class DLL_PUBLIC JournalReplayer
+    {
+        CommandExecutor&    m_executor;
+        double              m_speed;
+        std::function<std::shared_ptr<CommandExecutorContext>(std::uint64_t)>
+                            m_context_factory;
+    public:
+        JournalReplayer(CommandExecutor& executor, double speed = 1.0);
+
+        /**
+         * 1.0 replays at the original pace, 2.0 twice as fast and so on.
+         * 0 dispatches every line as soon as the previous line of the same thread is done.
+         * */
+        void set_speed(double speed);
+        double get_speed() const;
+        /**
+         * Maps the recorded context id into the context to dispatch into. The factory is called once per id.
+         * When not set, the executor's own factory is used for every line.
+         * */
+        void set_context_factory(
+                const std::function<std::shared_ptr<CommandExecutorContext>(std::uint64_t)>& factory);
+
+        /**
+         * The journal of the executor is detached during the replay, so the replayed lines are not recorded again,
+         * neither are the lines dispatched meanwhile by other threads. It is attached back afterwards.
+         * */
+        ReplayReport replay(const std::string& path);
+        ReplayReport replay(const std::vector<JournalRecord>& records);
+    };
+}
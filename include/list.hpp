@@ -0,0 +1,45 @@
+/**
+ * list.hpp - Decoding of the CT_LIST arguments straight into std::vector.
+ * The elements are separated by commas and may be enclosed into brackets: 1,2,3 or [1,2,3].
+ * Whitespace around the elements is allowed, which needs the argument to be quoted: "[1, 2, 3]".
+ * An empty argument or [] is an empty list, an empty element is an error.
+ *
+ * Lists of decimal integers without whitespace take the fast path: the whole list is validated
+ * and its commas are counted 16 octets at a time (SSE2, when it is available), then the vector
+ * is allocated once and the elements are converted 8 digits at a time.
+ * Overflow is checked exactly, an element which does not fit into the type throws std::out_of_range,
+ * and a malformed one std::invalid_argument, so the errors are reported like for any other argument.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    //
+    // The previous contents of out are replaced.
+    //
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<char>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<short>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<int>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<long>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<unsigned char>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<unsigned short>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<unsigned int>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<unsigned long>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<float>& out);
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<double>& out);
+    // accepts the same words as the bool arguments
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<bool>& out);
+    // the elements are taken as they are, without the surrounding whitespace
+    DLL_PUBLIC void decode_list(std::string_view text, std::vector<std::string>& out);
+}
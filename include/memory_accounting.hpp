@@ -0,0 +1,77 @@
+/**
+ * memory_accounting.hpp - Counting of the memory allocated by the current thread.
+ * While an AllocationScope is alive, allocations made by its thread are added to its counters.
+ * The CommandExecutor opens one scope per dispatch and keeps the totals in CommandStatistics.
+ *
+ * Allocations reach the scope in one of two ways:
+ *  - through a CountingMemoryResource, such as counting_memory_resource(), which is also returned by
+ *    CommandExecutor::get_memory_resource(). The parser of a dispatch, the contexts made by
+ *    CommandExecutorContext::create_factory() and the output buffers of BufferedContext and CaptureContext
+ *    are allocated from it, so a dispatch is accounted without anything else;
+ *  - when the library is built with NNWCLI_ALLOCATION_HOOK (CMake option of the same name, off by default),
+ *    the global operator new and delete are replaced, so every allocation of the thread is counted,
+ *    including the ones inside Command::execute. Since this affects the whole program, it is left
+ *    to the applications which don't replace them on their own.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    struct DLL_PUBLIC AllocationCounters
+    {
+        std::size_t     m_allocations = 0;
+        std::size_t     m_allocated_bytes = 0;
+        // bytes allocated and not yet freed within the scope, can be negative when
+        // the memory allocated before the scope is freed inside of it
+        std::int64_t    m_live_bytes = 0;
+        // maximum of m_live_bytes
+        std::int64_t    m_peak_bytes = 0;
+    };
+
+    class DLL_PUBLIC AllocationScope
+    {
+        AllocationScope*    m_parent;
+        AllocationCounters  m_counters;
+    public:
+        AllocationScope();
+        AllocationScope(AllocationScope&) = delete;
+        AllocationScope(AllocationScope&&) = delete;
+        // adds the counters into the enclosing scope, if there is one
+        ~AllocationScope();
+
+        const AllocationCounters& get_counters() const;
+
+        // innermost scope of the calling thread, or nullptr
+        static AllocationScope* current();
+        static void record_allocation(std::size_t bytes);
+        static void record_deallocation(std::size_t bytes);
+        // whether every allocation is counted, or only those of a CountingMemoryResource
+        static bool is_hooked();
+    };
+
+    class DLL_PUBLIC CountingMemoryResource : public std::pmr::memory_resource
+    {
+        std::pmr::memory_resource* m_upstream;
+    protected:
+        virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    public:
+        CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        std::pmr::memory_resource* get_upstream() const;
+    };
+    // shared by the whole process and never destroyed, so the memory allocated from it can outlive anything
+    DLL_PUBLIC std::pmr::memory_resource* counting_memory_resource();
+}
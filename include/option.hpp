@@ -0,0 +1,97 @@
+/**
+ * option.hpp - Options of the commands, which are given by their names anywhere in the argument line.
+ * The options are declared next to the arguments, in the constructor of the command:
+ *     m_options = {{{nnwcli::CT_UINTEGER, "port", "Port to listen on"}},
+ *                  {{nnwcli::CT_BOOL, "verbose", "Print every connection"}, 'v'}};
+ * and are written as --port=8080, while the CT_BOOL options are flags: --verbose or -v,
+ * and --verbose=no as well. A lone -- ends the options, whatever follows is positional.
+ * The parser finds all options in one pass before the command is executed and takes them out of the line,
+ * so the positional arguments are parsed as if the options were not there:
+ *     parser->parse_option("port", port);
+ *     const bool verbose = parser->has_option("verbose");
+ * Options are to be given before a CT_FULL argument, which takes the rest of the line:
+ * the options aren't looked for in its text, so it keeps the words that look like options.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "argument.hpp"
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    // --name of an option the command doesn't have
+    class DLL_PUBLIC unknown_option : public cli_error
+    {
+    public:
+        std::string m_name;
+        unknown_option(std::string name) : m_name(std::move(name)) {}
+        virtual const char* what() const noexcept override;
+    };
+    // value of an option which couldn't be converted into its type
+    class DLL_PUBLIC invalid_option_value : public cli_error
+    {
+    public:
+        std::string m_name;
+        // std::out_of_range instead of std::invalid_argument
+        bool m_out_of_range;
+        invalid_option_value(std::string name, const bool out_of_range) :
+            m_name(std::move(name)), m_out_of_range(out_of_range) {}
+        virtual const char* what() const noexcept override;
+    };
+
+    struct DLL_PUBLIC OptionDefinition : public ArgumentDefinition
+    {
+        // -s of a CT_BOOL flag, 0 when it has only the long name
+        char m_short = 0;
+
+        bool is_flag() const
+        {
+            return m_type == CT_BOOL;
+        }
+    };
+
+    /**
+     * Lookup of the options of a command by their names, built when the command is registered.
+     * */
+    class DLL_PUBLIC OptionIndex
+    {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    private:
+        std::vector<OptionDefinition>   m_options;
+        // open addressing over the hashes of the long names, entries are the indices + 1
+        std::vector<std::uint16_t>      m_buckets;
+        // indices + 1 of the short names, which are ASCII letters
+        std::array<std::uint16_t, 128>  m_short = {};
+        // positional arguments before the CT_FULL one, npos when the command has none
+        std::size_t                     m_full_position = npos;
+    public:
+        /**
+         * full_position is the position of the CT_FULL argument among the arguments, the optional ones included.
+         * Throws std::invalid_argument when a name is declared twice or a short name isn't a letter.
+         * */
+        void build(const std::vector<OptionDefinition>& options, std::size_t full_position = npos);
+
+        // npos when there is no such option
+        std::size_t find(std::string_view name) const;
+        std::size_t find_short(char name) const;
+
+        std::size_t get_count() const;
+        bool empty() const;
+        const OptionDefinition& get(std::size_t index) const;
+        std::size_t get_full_position() const;
+    };
+}
@@ -9,6 +9,12 @@
  * When the arguments should end, parse_finish() method should be called by the command implementation,
  * indicating that the arguments should not be parsed anymore. It will throw too_many_arguments when
  * the parser is not exhausted yet.
+ * Arguments of custom types are parsed by parse_custom(), through the TypeRegistry given by the executor.
+ * By default their textual form is taken as a string argument and converted by the type.
+ * CT_LIST arguments are decoded by parse_list() into a std::vector of the element type,
+ * and CT_BLOB arguments by parse_blob() into a std::vector or a buffer of the caller.
+ * Options of the command (see "option.hpp") are not taken by the positional parsers,
+ * they are looked up by their names with has_option() and parse_option().
  * 
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -18,10 +24,21 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <sys/types.h>
 #include <exception>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "custom_type.hpp"
 #include "globals.hpp"
+#include "list.hpp"
+#include "option.hpp"
+#include "pattern.hpp"
 
 
 namespace nnwcli
@@ -47,13 +64,32 @@ namespace nnwcli
         virtual const char* what() const noexcept override;
     };
 
+    class TypeRegistry;
+
     // std::invalid_argument can be raised
 
     class DLL_PUBLIC AbstractParser
     {
     protected:
         std::size_t m_pos = 0, m_argument_pos = 0;
+        const TypeRegistry* m_type_registry = nullptr;
+        const OptionIndex* m_options = nullptr;
         virtual void _throw_if_exhausted() = 0;
+        // parser of the value of --name=value, nullptr when the option isn't given with a value
+        virtual std::unique_ptr<AbstractParser> _option_value(std::size_t index) const;
+        // throws unknown_option
+        std::size_t _find_option(std::string_view name) const;
+        /**
+         * Takes the next argument as a view of the parser's own text, when it needs no unescaping.
+         * Returns false without taking it otherwise, then parse_string() has to copy it.
+         * The default can't give a view at all. Used to decode the lists and the blobs without copying them first.
+         * */
+        virtual bool _plain_argument(std::string_view& out);
+
+        template<typename T>
+        struct _IsVector : std::false_type {};
+        template<typename T>
+        struct _IsVector<std::vector<T>> : std::true_type {};
     public:
         virtual ~AbstractParser() = default;
         virtual bool exhausted() const = 0;
@@ -62,6 +98,12 @@ namespace nnwcli
         virtual void set_pos(std::size_t pos);
         virtual void reset_pos();
         virtual void reset_argument_pos();
+        void set_argument_pos(std::size_t argument_pos);
+        const TypeRegistry* get_type_registry() const;
+        void set_type_registry(const TypeRegistry* registry);
+        // set by the executor before the command is executed, the parser finds the options in its arguments
+        virtual void set_options(const OptionIndex* options);
+        const OptionIndex* get_options() const;
 
         //
         // Parsers, will advance m_pos and give the next argument, or raise one of the exceptions.
@@ -70,6 +112,8 @@ namespace nnwcli
         //
 
         virtual void parse_finish();
+        // moves past the next argument without converting it
+        virtual bool skip(bool required = true);
         virtual bool parse_string(std::string& out, bool required = true) = 0;
         virtual bool parse_tinyint(char& out, bool required = true) = 0;
         virtual bool parse_shortint(short& out, bool required = true) = 0;
@@ -83,8 +127,153 @@ namespace nnwcli
         virtual bool parse_double(double& out, bool required = true) = 0;
         virtual bool parse_bool(bool& out, bool required = true) = 0;
         virtual bool parse_full(std::string& out, bool required = false) = 0;
-        // This will attempt to access the custom parser registry, otherwise it will throw unknown_custom_type
-        //bool parse_custom(void* out, const std::string& custom_type_name, bool required = true);
+        // a string matching the pattern, otherwise std::invalid_argument
+        virtual bool parse_pattern(std::string& out, const Pattern& pattern, bool required = true);
+        // Accesses the custom type registry, throws unknown_custom_type when the type isn't there.
+        virtual bool parse_custom(CustomValue& out, CustomTypeId type, bool required = true);
+        // looks the type up by its name first, the id of ArgumentDefinition should be preferred
+        bool parse_custom(CustomValue& out, const std::string& type_name, bool required = true);
+        template<typename T>
+        bool parse_custom_as(T& out, const CustomTypeId type, const bool required = true)
+        {
+            CustomValue value;
+
+            if(!parse_custom(value, type, required))
+                return false;
+            out = std::move(value.get<T>());
+            return true;
+        }
+        // a list of the type of T, the elements are decoded straight from the argument, see "list.hpp"
+        template<typename T>
+        bool parse_list(std::vector<T>& out, const bool required = true)
+        {
+            std::string text;
+            std::string_view view;
+
+            if(!_plain_argument(view))
+            {
+                if(!parse_string(text, required))
+                    return false;
+                view = text;
+            }
+            try
+            {
+                decode_list(view, out);
+            }
+            catch(...)
+            {
+                m_argument_pos--;
+                throw;
+            }
+            return true;
+        }
+        /**
+         * Parses the next argument into out the way the definition declares it: std::string is matched
+         * against the pattern of a CT_PATTERN or takes the rest of the line for CT_FULL,
+         * std::vector<std::uint8_t> is a blob for CT_BLOB, other vectors are lists.
+         * */
+        template<typename T>
+        bool parse_as(const ArgumentDefinition& definition, T& out, const bool required = true)
+        {
+            if constexpr(std::is_same_v<T, std::string>)
+            {
+                if(definition.m_type == CT_PATTERN && definition.m_pattern)
+                    return parse_pattern(out, *definition.m_pattern, required);
+                if(definition.m_type == CT_FULL)
+                    return parse_full(out, required);
+                return parse_string(out, required);
+            }
+            else if constexpr(std::is_same_v<T, CustomValue>)
+                return parse_custom(out, definition.m_custom_id, required);
+            else if constexpr(std::is_same_v<T, std::vector<std::uint8_t>>)
+            {
+                if(definition.m_type == CT_BLOB)
+                    return parse_blob(out, required);
+                return parse_list(out, required);
+            }
+            else if constexpr(_IsVector<T>::value)
+                return parse_list(out, required);
+            else if constexpr(std::is_same_v<T, char>)
+                return parse_tinyint(out, required);
+            else if constexpr(std::is_same_v<T, short>)
+                return parse_shortint(out, required);
+            else if constexpr(std::is_same_v<T, int>)
+                return parse_integer(out, required);
+            else if constexpr(std::is_same_v<T, long>)
+                return parse_bigint(out, required);
+            else if constexpr(std::is_same_v<T, unsigned char>)
+                return parse_unsigned_tinyint(out, required);
+            else if constexpr(std::is_same_v<T, unsigned short>)
+                return parse_unsigned_shortint(out, required);
+            else if constexpr(std::is_same_v<T, unsigned int>)
+                return parse_unsigned_integer(out, required);
+            else if constexpr(std::is_same_v<T, unsigned long>)
+                return parse_unsigned_bigint(out, required);
+            else if constexpr(std::is_same_v<T, float>)
+                return parse_float(out, required);
+            else if constexpr(std::is_same_v<T, double>)
+                return parse_double(out, required);
+            else
+            {
+                static_assert(std::is_same_v<T, bool>, "no argument type is parsed into T");
+                return parse_bool(out, required);
+            }
+        }
+        // octets of the argument decoded from its hex: or b64: form, see "blob.hpp"
+        bool parse_blob(std::vector<std::uint8_t>& out, bool required = true);
+        // size is set to the number of octets, std::out_of_range when they don't fit into capacity
+        bool parse_blob(std::uint8_t* buffer, std::size_t capacity, std::size_t& size, bool required = true);
+
+        //
+        // Options, by their names or their indices in the OptionIndex. Throw unknown_option
+        // when the command has no such option.
+        //
+
+        bool has_option(std::string_view name) const;
+        virtual bool has_option(std::size_t index) const;
+        /**
+         * Gives the value of --name=value converted into T, as an argument of the option's type would be.
+         * A flag given without a value is true. Returns false when the option isn't given.
+         * Wrong values throw invalid_option_value.
+         * */
+        template<typename T>
+        bool parse_option(const std::string_view name, T& out)
+        {
+            const std::size_t index = _find_option(name);
+            const OptionDefinition& option = m_options->get(index);
+            const std::unique_ptr<AbstractParser> value = _option_value(index);
+
+            if(!value)
+            {
+                if constexpr(std::is_same_v<T, bool>)
+                {
+                    if(has_option(index))
+                    {
+                        out = true;
+                        return true;
+                    }
+                }
+                return false;
+            }
+            try
+            {
+                value->parse_as(option, out);
+            }
+            catch(const std::out_of_range& e)
+            {
+                throw invalid_option_value(option.m_name, true);
+            }
+            catch(const std::invalid_argument& e)
+            {
+                throw invalid_option_value(option.m_name, false);
+            }
+            // --name= without a value
+            catch(const not_enough_arguments& e)
+            {
+                throw invalid_option_value(option.m_name, false);
+            }
+            return true;
+        }
 
         //
         // Shorthand operator parsers, for C++ convenience. Interpreted as required parses.
@@ -1,6 +1,11 @@
 /**
  * parser/argline_parser.hpp - CLI parser for extracting textual space-separated arguments.
  * Capable of translating escape sequences and handling format errors, argument-wise errors thrown by the parser.
+ * The options of the command are found in one pass when they are set, and their tokens are taken out of the line.
+ * Escapes can produce any octets, so with an EncodingPolicy other than EP_PASS_THROUGH the unescaped values
+ * are checked to be valid UTF-8: rejected with std::invalid_argument or repaired (see "util/utf8.hpp").
+ * The line is kept in the memory resource given to the constructor, the executor gives the counting one
+ * (see "memory_accounting.hpp").
  * 
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -13,8 +18,14 @@
 #include <cstddef>
 #include <sys/types.h>
 #include <exception>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "globals.hpp"
 #include "parser/abstract_parser.hpp"
+#include "util/utf8.hpp"
 
 
 namespace nnwcli
@@ -42,18 +53,37 @@ namespace nnwcli
 
     class DLL_PUBLIC ArglineParser : public AbstractParser
     {
-        std::string m_argline;
+        struct _OptionSlot
+        {
+            bool        m_given = false;
+            bool        m_has_value = false;
+            // the token after =, still quoted and escaped
+            std::string m_value;
+        };
+
+        std::pmr::string m_argline;
+        // one per option of the command
+        std::vector<_OptionSlot> m_option_slots;
+        EncodingPolicy m_encoding_policy = EP_PASS_THROUGH;
 
         // moves m_pos to the beginning of the next argument, otherwise sets m_pos to -1
         // if m_pos already was -1 then throws not_enough_arguments
         void _next();
 
-        static std::size_t _find_unescaped_quote(const std::string& argline, const std::size_t start = 0);
-        static std::size_t _find_unescaped_whitespace(const std::string& argline, const std::size_t start = 0);
-        static void _unescape_into(std::string& out, const std::string& in, const std::size_t start = 0);
+        static std::size_t _find_unescaped_quote(std::string_view argline, const std::size_t start = 0);
+        static std::size_t _find_unescaped_whitespace(std::string_view argline, const std::size_t start = 0);
+        static void _unescape_into(std::string& out, std::string_view in, const std::size_t start = 0);
         static std::size_t _interpret_escape_into(std::string& out, std::size_t n, const char* seq);
+        // applies the encoding policy to out when escaped had escapes in it
+        void _check_encoding(std::string& out, std::string_view escaped) const;
+        // end of the token starting at start, past the closing quote for the quoted ones
+        std::size_t _find_token_end(std::size_t start) const;
+        void _index_options();
     protected:
         virtual void _throw_if_exhausted() override;
+        virtual std::unique_ptr<AbstractParser> _option_value(std::size_t index) const override;
+        // unquoted arguments without escapes are viewed right in m_argline
+        virtual bool _plain_argument(std::string_view& out) override;
 
     public:
         virtual ~ArglineParser() = default;
@@ -63,9 +93,13 @@ namespace nnwcli
 
         ArglineParser(
                 const std::string argline,
-                const std::size_t pos = 0);
+                const std::size_t pos = 0,
+                std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
         virtual bool exhausted() const override;
+        virtual void set_options(const OptionIndex* options) override;
+        virtual bool has_option(std::size_t index) const override;
+        using AbstractParser::has_option;
 
         //
         // Parsers, will advance m_pos and give the next argument, or raise one of the exceptions.
@@ -73,6 +107,7 @@ namespace nnwcli
         // object is received as a first argument.
         //
 
+        virtual bool skip(bool required = true) override;
         virtual bool parse_string(std::string& out, bool required = true) override;
         virtual bool parse_tinyint(char& out, bool required = true) override;
         virtual bool parse_shortint(short& out, bool required = true) override;
@@ -88,14 +123,17 @@ namespace nnwcli
         virtual bool parse_double(double& out, bool required = true) override;
         virtual bool parse_bool(bool& out, bool required = true) override;
         virtual bool parse_full(std::string& out, bool required = false) override;
-        // This will attempt to access the custom parser registry, otherwise it will throw unknown_custom_type
-        //bool parse_custom(void* out, const std::string& custom_type_name, bool required = true);
+        // unquoted arguments without escapes are matched while their end is searched for
+        virtual bool parse_pattern(std::string& out, const Pattern& pattern, bool required = true) override;
 
 
         //
         // Only for an argline parser.
         //
-        const std::string& get_argline() const;
+        // without the option tokens, once the options are set
+        std::string_view get_argline() const;
+        void set_encoding_policy(EncodingPolicy policy);
+        EncodingPolicy get_encoding_policy() const;
 
         //
         // Shorthand operator parsers, for C++ convenience. Interpreted as required parses.
@@ -0,0 +1,123 @@
+/**
+ * parser/binary_parser.hpp - Parser of typed argument lists in a compact binary form, for machine clients.
+ * Text arguments have to be escaped by the client and converted back by ArglineParser, while the binary form
+ * carries the values as they are. BinaryArgumentEncoder writes it:
+ *     BinaryArgumentEncoder encoder;
+ *     encoder.push_string("Hello World");
+ *     encoder.push_integer(10);
+ *     executor.dispatch_binary("greet", encoder.get_data(), context);
+ *
+ * Every argument is a type octet (ArgumentTypes) followed by the value:
+ *     CT_STRING and CT_FULL are a varint length and the octets,
+ *     signed integers are zigzag varints, unsigned integers are varints,
+ *     CT_FLOAT and CT_DOUBLE are 4 and 8 octets of IEEE 754 in little endian,
+ *     CT_BOOL is a single octet.
+ * Values are decoded only when they are parsed, straight from the buffer, which is borrowed and
+ * has to outlive the parser. Integers of any width are accepted for any other width of the same
+ * signedness, and floats for doubles, the range is checked like in the text form.
+ * Truncated or malformed input throws binary_format_error, an argument of another type std::invalid_argument.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "argument_types.hpp"
+#include "globals.hpp"
+#include "parser/abstract_parser.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC binary_format_error : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override;
+    };
+
+    class DLL_PUBLIC BinaryParser : public AbstractParser
+    {
+        const char*     m_data;
+        std::size_t     m_size;
+
+        // type of the next argument, without consuming it
+        ArgumentTypes _peek_type() const;
+        // consumes the type octet and the value of an integer, checks the signedness
+        std::int64_t _read_signed();
+        std::uint64_t _read_unsigned();
+        double _read_floating();
+        std::string_view _read_string(bool full);
+        // whether the next argument has to be parsed, or false for a missing optional one
+        bool _begin(bool required);
+
+        template<typename T>
+        bool _parse_signed(T& out, bool required);
+        template<typename T>
+        bool _parse_unsigned(T& out, bool required);
+    protected:
+        virtual void _throw_if_exhausted() override;
+    public:
+        BinaryParser(const char* data, std::size_t n);
+        BinaryParser(std::string_view data);
+        virtual ~BinaryParser() = default;
+
+        virtual bool exhausted() const override;
+        virtual bool skip(bool required = true) override;
+
+        virtual bool parse_string(std::string& out, bool required = true) override;
+        virtual bool parse_tinyint(char& out, bool required = true) override;
+        virtual bool parse_shortint(short& out, bool required = true) override;
+        virtual bool parse_integer(int& out, bool required = true) override;
+        virtual bool parse_bigint(long& out, bool required = true) override;
+        virtual bool parse_unsigned_tinyint(unsigned char& out, bool required = true) override;
+        virtual bool parse_unsigned_shortint(unsigned short& out, bool required = true) override;
+        virtual bool parse_unsigned_integer(unsigned int& out, bool required = true) override;
+        virtual bool parse_unsigned_bigint(unsigned long& out, bool required = true) override;
+        virtual bool parse_float(float& out, bool required = true) override;
+        virtual bool parse_double(double& out, bool required = true) override;
+        virtual bool parse_bool(bool& out, bool required = true) override;
+        virtual bool parse_full(std::string& out, bool required = false) override;
+
+        //
+        // Only for a binary parser, the views point into the buffer and are not copied.
+        //
+        bool parse_string_view(std::string_view& out, bool required = true);
+        bool parse_full_view(std::string_view& out, bool required = false);
+    };
+
+    class DLL_PUBLIC BinaryArgumentEncoder
+    {
+        std::string m_data;
+
+        void _push_string(ArgumentTypes type, std::string_view value);
+    public:
+        BinaryArgumentEncoder() = default;
+
+        void push_string(std::string_view value);
+        void push_tinyint(char value);
+        void push_shortint(short value);
+        void push_integer(int value);
+        void push_bigint(long value);
+        void push_unsigned_tinyint(unsigned char value);
+        void push_unsigned_shortint(unsigned short value);
+        void push_unsigned_integer(unsigned int value);
+        void push_unsigned_bigint(unsigned long value);
+        void push_float(float value);
+        void push_double(double value);
+        void push_bool(bool value);
+        // the rest of the line, no arguments can follow it
+        void push_full(std::string_view value);
+
+        const std::string& get_data() const;
+        // moves the encoded arguments out and clears the encoder
+        std::string take();
+        // keeps the capacity
+        void clear();
+    };
+}
@@ -2,12 +2,16 @@
  * parser/placeholder_parser.hpp - Passive parser implementation for non-textual command invocation.
  * Can be useful, for example, when an alternative interface, other than CLI is used,
  * but the toolkit should be shared.
- * This class utilizes deques for each type of command arguments and it isn't used directly
- * by the CommandExecutor, especially not in dispatch_line.
+ * The arguments are kept in a single contiguous array of 16-byte tagged slots, the first few of them
+ * inside the parser itself, and the strings are appended into one arena. Pushing a few numbers and
+ * short strings allocates nothing, and clear() keeps the capacity, so a reused parser stops allocating.
+ * CommandExecutor uses it for invoke(), but not in dispatch_line.
  * Instance can be used to directly invoke commands.
  * For example, using methods such as push_string("Hello World") and push_integer(10), then,
  * passing it into a context as a new parser, the command will receive the arguments
  * as if they were textually written.
+ * push() picks the argument type from the C++ type at compile time, which is what
+ * CommandExecutor::invoke() uses; wrap a string into FullArgument to pass it as CT_FULL.
  * 
  * License: The MIT License.
  * Copyright 2025 dernisnw@neonw.su
@@ -20,38 +24,76 @@
 #include "custom_type.hpp"
 #include "globals.hpp"
 #include "parser/abstract_parser.hpp"
-#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 namespace nnwcli
 {
+    // a string passed to push() as the rest of the line (CT_FULL) instead of a single argument
+    struct DLL_PUBLIC FullArgument
+    {
+        std::string_view    m_value;
+    };
+
     class DLL_PUBLIC PlaceholderParser : public AbstractParser
     {
-        std::deque<std::pair<ArgumentTypes, std::size_t>> m_queue_types;
-        std::deque<std::string> m_queue_string;
-        std::deque<char> m_queue_tinyint;
-        std::deque<short> m_queue_shortint;
-        std::deque<int> m_queue_integer;
-        std::deque<long> m_queue_bigint;
-        std::deque<float> m_queue_float;
-        std::deque<double> m_queue_double;
-        std::deque<bool> m_queue_bool;
-        std::deque<AbstractCustomType> m_queue_custom;
-        std::string m_full_string;
+    public:
+        // slots stored within the parser, more of them are allocated on the heap
+        static constexpr std::size_t inline_slots = 4;
+    private:
+        struct _Slot
+        {
+            union
+            {
+                std::int64_t    m_signed;
+                std::uint64_t   m_unsigned;
+                float           m_float;
+                double          m_double;
+                bool            m_bool;
+                // location of a string in m_arena
+                struct
+                {
+                    std::uint32_t   m_offset;
+                    std::uint32_t   m_size;
+                }               m_string;
+            };
+            ArgumentTypes       m_type;
+        };
+        static_assert(sizeof(_Slot) == 16, "argument slots are expected to take 16 bytes");
+
+        _Slot                       m_inline[inline_slots];
+        std::unique_ptr<_Slot[]>    m_heap;
+        // either m_inline or m_heap
+        _Slot*                      m_slots;
+        std::size_t                 m_count;
+        std::size_t                 m_capacity;
+        std::string                 m_arena;
+        // values of the CT_STRING_CUSTOM slots, which hold the index
+        std::vector<CustomValue>    m_custom;
+        std::string                 m_full_string;
 
+        _Slot& _push(ArgumentTypes type);
+        /**
+         * The slot of the next argument, or nullptr when there are no more and it isn't required.
+         * Integers of other widths with the same signedness and floats for doubles are accepted,
+         * like their textual forms, other types throw std::invalid_argument.
+         * */
+        const _Slot* _pick(ArgumentTypes expected_type, bool required);
         template<typename T>
-        bool pick_from_queue(T& out, ArgumentTypes expected_type, std::deque<T>& deque, bool required = true);
+        bool _pick_integer(T& out, ArgumentTypes expected_type, bool required);
     public:
+        PlaceholderParser();
+        PlaceholderParser(const PlaceholderParser& other);
+        PlaceholderParser& operator=(const PlaceholderParser& other);
         virtual ~PlaceholderParser() override = default;
-        virtual std::deque<std::pair<ArgumentTypes, std::size_t>>* get_types_queue();
-        virtual std::deque<std::string>* get_string_queue();
-        virtual std::deque<char>* get_tinyint_queue();
-        virtual std::deque<short>* get_shortint_queue();
-        virtual std::deque<int>* get_integer_queue();
-        virtual std::deque<long>* get_bigint_queue();
-        virtual std::deque<float>* get_float_queue();
-        virtual std::deque<double>* get_double_queue();
-        virtual std::deque<bool>* get_bool_queue();
 
         virtual void push_string(const std::string& value);
+        void push_string(std::string_view value);
+        void push_string(const char* value);
         virtual void push_tinyint(char value);
         virtual void push_shortint(short value);
         virtual void push_integer(int value);
@@ -63,13 +105,64 @@ namespace nnwcli
         virtual void push_float(float value);
         virtual void push_double(double value);
         virtual void push_bool(bool value);
+        // the value has to carry its type id, see CustomValue::set_type()
+        virtual void push_custom(CustomValue value);
+        // forgets the arguments and rewinds the parser, keeping the allocated memory
         virtual void clear();
 
+        // pushes the value as the argument type matching its C++ type
+        template<typename T>
+        void push(const T& value)
+        {
+            using U = std::decay_t<T>;
+
+            if constexpr(std::is_same_v<U, bool>)
+                push_bool(value);
+            else if constexpr(std::is_same_v<U, CustomValue>)
+                push_custom(value);
+            else if constexpr(std::is_same_v<U, FullArgument>)
+                set_full_string(std::string(value.m_value));
+            else if constexpr(std::is_same_v<U, char> || std::is_same_v<U, signed char>)
+                push_tinyint(static_cast<char>(value));
+            else if constexpr(std::is_integral_v<U> && std::is_signed_v<U>)
+            {
+                if constexpr(sizeof(U) <= sizeof(short))
+                    push_shortint(value);
+                else if constexpr(sizeof(U) <= sizeof(int))
+                    push_integer(value);
+                else
+                    push_bigint(static_cast<long>(value));
+            }
+            else if constexpr(std::is_integral_v<U>)
+            {
+                if constexpr(sizeof(U) == 1)
+                    push_unsigned_tinyint(value);
+                else if constexpr(sizeof(U) <= sizeof(unsigned short))
+                    push_unsigned_shortint(value);
+                else if constexpr(sizeof(U) <= sizeof(unsigned int))
+                    push_unsigned_integer(value);
+                else
+                    push_unsigned_bigint(static_cast<unsigned long>(value));
+            }
+            else if constexpr(std::is_same_v<U, float>)
+                push_float(value);
+            else if constexpr(std::is_floating_point_v<U>)
+                push_double(static_cast<double>(value));
+            else if constexpr(std::is_convertible_v<const T&, std::string_view>)
+                push_string(std::string_view(value));
+            else
+                static_assert(!sizeof(U), "no argument type matches this C++ type");
+        }
+
+        std::size_t get_count() const;
+        ArgumentTypes get_type(std::size_t index) const;
+
         const std::string& get_full_string() const;
         void set_full_string(const std::string& value);
         void set_full_string(const char* value);
 
         virtual bool exhausted() const override;
+        virtual bool skip(bool required = true) override;
         virtual void _throw_if_exhausted() override;
 
         //
@@ -91,7 +184,8 @@ namespace nnwcli
         virtual bool parse_double(double& out, bool required = true) override;
         virtual bool parse_bool(bool& out, bool required = true) override;
         virtual bool parse_full(std::string& out, bool required = false) override;
-        // This will attempt to access the custom parser registry, otherwise it will throw unknown_custom_type
-        //bool parse_custom(void* out, const std::string& custom_type_name, bool required = true);
+        using AbstractParser::parse_custom;
+        // takes a pushed custom value, or parses a pushed string with the type registry
+        virtual bool parse_custom(CustomValue& out, CustomTypeId type, bool required = true) override;
     };
 }
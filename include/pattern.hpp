@@ -0,0 +1,85 @@
+/**
+ * pattern.hpp - Patterns of the CT_PATTERN arguments, compiled into a table-driven DFA.
+ * A pattern always matches the whole argument. The supported subset of the regular expressions:
+ *     literal characters, . for any octet, \ escapes of the special characters,
+ *     \d \w \s and their negations \D \W \S,
+ *     [a-z0-9_] classes with ranges, [^...] negated classes, a ] right after [ or [^ is literal,
+ *     (...) groups, | alternatives, * + ? and {m} {m,} {m,n} repetitions.
+ * Matching is done over octets, so a multi-octet UTF-8 character is matched by as many dots.
+ * The pattern is compiled once, when the command is registered, and matching an argument
+ * costs one table lookup per octet, without backtracking and without allocations.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC pattern_error : public cli_error
+    {
+    public:
+        // position in the pattern where the error was found
+        std::size_t m_pos;
+        pattern_error(const std::size_t pos)
+        {
+            m_pos = pos;
+        }
+        virtual const char* what() const noexcept override;
+    };
+
+    class DLL_PUBLIC Pattern
+    {
+    public:
+        // limits of the compiled automaton, larger patterns throw pattern_error
+        static constexpr std::size_t max_nfa_nodes = 16384;
+        static constexpr std::size_t max_dfa_states = 4096;
+        // state in which the text can't match anymore, whatever follows
+        static constexpr std::uint32_t dead_state = 0;
+    private:
+        std::string                         m_source;
+        // octets that are never told apart by the pattern share a class, so the table has a column per class
+        std::array<std::uint8_t, 256>       m_classes;
+        std::size_t                         m_class_count;
+        // m_class_count entries per state
+        std::vector<std::uint32_t>          m_transitions;
+        std::vector<std::uint8_t>           m_accepting;
+        std::uint32_t                       m_start;
+    public:
+        // throws pattern_error
+        explicit Pattern(std::string source);
+
+        bool matches(std::string_view text) const;
+
+        //
+        // Stepping through the automaton, for the parsers that match while they tokenize.
+        //
+        std::uint32_t get_start() const
+        {
+            return m_start;
+        }
+        std::uint32_t step(const std::uint32_t state, const unsigned char octet) const
+        {
+            return m_transitions[state * m_class_count + m_classes[octet]];
+        }
+        bool accepts(const std::uint32_t state) const
+        {
+            return m_accepting[state];
+        }
+
+        const std::string& get_source() const;
+        std::size_t get_state_count() const;
+        std::size_t get_class_count() const;
+    };
+}
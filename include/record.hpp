@@ -0,0 +1,157 @@
+/**
+ * record.hpp - Structured output of the commands, rendered by a serializer selected per context.
+ *     context->begin_record("user");
+ *     context->field("name", name).field("age", age);
+ *     context->end_record();
+ * The same record can be shown as human readable text, as a line of JSON, or in a compact binary form,
+ * so machine clients neither need the text formatting of the command nor have to parse it back.
+ *
+ * The binary form is a sequence of frames, each one is a varint length followed by that many octets:
+ *     varint name length, name, then the fields until the end of the frame:
+ *     type octet (RecordValue::Type), varint key length, key, value
+ * String values are a varint length and the octets, signed integers are zigzag varints,
+ * unsigned integers are varints, doubles are 8 octets of IEEE 754 in little endian, booleans are a single octet.
+ * decode_binary_record() reads it back.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class CommandExecutorContext;
+
+    // field() outside of a record, or begin_record() inside of another one
+    class DLL_PUBLIC record_error : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override;
+    };
+    class DLL_PUBLIC record_format_error : public cli_error
+    {
+    public:
+        virtual const char* what() const noexcept override;
+    };
+
+    struct DLL_PUBLIC RecordValue
+    {
+        enum Type : unsigned char
+        {
+            RT_STRING = 0,
+            RT_SIGNED,
+            RT_UNSIGNED,
+            RT_DOUBLE,
+            RT_BOOL,
+        };
+        Type                m_type;
+        union
+        {
+            std::int64_t    m_signed;
+            std::uint64_t   m_unsigned;
+            double          m_double;
+            bool            m_bool;
+        };
+        std::string_view    m_string;
+
+        RecordValue() : m_type(RT_STRING), m_unsigned(0) {}
+        RecordValue(const std::string_view value) : m_type(RT_STRING), m_unsigned(0), m_string(value) {}
+        RecordValue(const std::int64_t value) : m_type(RT_SIGNED), m_signed(value) {}
+        RecordValue(const std::uint64_t value) : m_type(RT_UNSIGNED), m_unsigned(value) {}
+        RecordValue(const double value) : m_type(RT_DOUBLE), m_double(value) {}
+        RecordValue(const bool value) : m_type(RT_BOOL), m_unsigned(0)
+        {
+            m_bool = value;
+        }
+    };
+
+    /**
+     * Renders the records into the context. Serializers may keep state between the calls,
+     * so every context needs its own instance.
+     * */
+    class DLL_PUBLIC RecordSerializer
+    {
+    public:
+        virtual ~RecordSerializer() = default;
+
+        virtual void begin_record(CommandExecutorContext& ctx, std::string_view name) = 0;
+        virtual void field(CommandExecutorContext& ctx, std::string_view key, const RecordValue& value) = 0;
+        virtual void end_record(CommandExecutorContext& ctx) = 0;
+    };
+
+    /**
+     * The text commands normally write, one line per record:
+     *     name: John, age: 42
+     * The name of the record is not shown.
+     * */
+    class DLL_PUBLIC TextRecordSerializer : public RecordSerializer
+    {
+        bool    m_first;
+    public:
+        TextRecordSerializer();
+        virtual void begin_record(CommandExecutorContext& ctx, std::string_view name) override;
+        virtual void field(CommandExecutorContext& ctx, std::string_view key, const RecordValue& value) override;
+        virtual void end_record(CommandExecutorContext& ctx) override;
+    };
+
+    /**
+     * One JSON object per line, the name of the record goes into the "record" key:
+     *     {"record":"user","name":"John","age":42}
+     * Strings are escaped but otherwise passed as they are, so they should be valid UTF-8.
+     * Non-finite doubles become null.
+     * */
+    class DLL_PUBLIC JsonLinesSerializer : public RecordSerializer
+    {
+    public:
+        virtual void begin_record(CommandExecutorContext& ctx, std::string_view name) override;
+        virtual void field(CommandExecutorContext& ctx, std::string_view key, const RecordValue& value) override;
+        virtual void end_record(CommandExecutorContext& ctx) override;
+    };
+
+    /**
+     * Length-prefixed binary frames, see the top of the file.
+     * The frame is assembled in memory, since its length goes first, and written at end_record().
+     * */
+    class DLL_PUBLIC BinaryRecordSerializer : public RecordSerializer
+    {
+        std::string     m_frame;
+        std::string     m_prefix;
+    public:
+        virtual void begin_record(CommandExecutorContext& ctx, std::string_view name) override;
+        virtual void field(CommandExecutorContext& ctx, std::string_view key, const RecordValue& value) override;
+        virtual void end_record(CommandExecutorContext& ctx) override;
+    };
+
+    enum RecordFormat : unsigned char
+    {
+        RF_TEXT = 0,
+        RF_JSON_LINES,
+        RF_BINARY,
+    };
+    DLL_PUBLIC std::shared_ptr<RecordSerializer> make_record_serializer(RecordFormat format);
+
+    struct DLL_PUBLIC DecodedRecord
+    {
+        std::string_view    m_name;
+        std::vector<std::pair<std::string_view, RecordValue>>
+                            m_fields;
+    };
+    /**
+     * Decodes a single binary frame from data[0..n). The strings of the record point into data.
+     * Returns the amount of octets consumed, or 0 if the frame is not complete yet.
+     * Throws record_format_error if the frame is malformed.
+     * */
+    DLL_PUBLIC std::size_t decode_binary_record(const char* data, std::size_t n, DecodedRecord& record);
+}
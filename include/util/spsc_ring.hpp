@@ -0,0 +1,133 @@
+/**
+ * util/spsc_ring.hpp - Publicly available code for a lock-free single-producer single-consumer byte ring.
+ * One thread may write and another one may read at the same time, without any locking.
+ * Each side keeps a cached copy of the other side's position, so the shared positions
+ * are only touched when the cached ones run out.
+ * */
+
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class SpscByteRing
+    {
+        std::unique_ptr<char[]>     m_data;
+        std::size_t                 m_capacity;
+        // positions grow forever, the index into m_data is position & (m_capacity - 1)
+        alignas(64) std::atomic<std::size_t>
+                                    m_head;
+        std::size_t                 m_cached_tail;
+        alignas(64) std::atomic<std::size_t>
+                                    m_tail;
+        std::size_t                 m_cached_head;
+    public:
+        // the capacity is rounded up to a power of two
+        explicit SpscByteRing(std::size_t capacity) :
+            m_capacity(1), m_head(0), m_cached_tail(0), m_tail(0), m_cached_head(0)
+        {
+            while(m_capacity < capacity)
+                m_capacity <<= 1;
+            m_data = std::make_unique<char[]>(m_capacity);
+        }
+        SpscByteRing(const SpscByteRing&) = delete;
+        SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+        std::size_t capacity() const
+        {
+            return m_capacity;
+        }
+        // octets written and not consumed yet, safe to call from any thread
+        std::size_t size() const
+        {
+            // the head is only consistent with the tail that hasn't moved while it was loaded
+            std::size_t tail = m_tail.load(std::memory_order_acquire);
+            for(;;)
+            {
+                const std::size_t head = m_head.load(std::memory_order_acquire);
+                const std::size_t again = m_tail.load(std::memory_order_acquire);
+                if(again == tail)
+                    return head - tail;
+                tail = again;
+            }
+        }
+
+        //
+        // producer side
+        //
+
+        std::size_t writable()
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            return m_capacity - (m_head.load(std::memory_order_relaxed) - m_cached_tail);
+        }
+        // writes as much as fits, returns the amount written
+        std::size_t write_some(const char* data, std::size_t n)
+        {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+
+            if(m_capacity - (head - m_cached_tail) < n)
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+            const std::size_t free = m_capacity - (head - m_cached_tail);
+            if(n > free)
+                n = free;
+            if(!n)
+                return 0;
+
+            const std::size_t index = head & (m_capacity - 1);
+            const std::size_t first = n < m_capacity - index ? n : m_capacity - index;
+            std::memcpy(m_data.get() + index, data, first);
+            std::memcpy(m_data.get(), data + first, n - first);
+            m_head.store(head + n, std::memory_order_release);
+            return n;
+        }
+        // writes everything or nothing
+        bool try_write(const char* data, const std::size_t n)
+        {
+            if(n > m_capacity)
+                return false;
+            if(m_capacity - (m_head.load(std::memory_order_relaxed) - m_cached_tail) < n)
+            {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if(m_capacity - (m_head.load(std::memory_order_relaxed) - m_cached_tail) < n)
+                    return false;
+            }
+            write_some(data, n);
+            return true;
+        }
+
+        //
+        // consumer side
+        //
+
+        std::size_t readable()
+        {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+            if(m_cached_head == tail)
+                m_cached_head = m_head.load(std::memory_order_acquire);
+            return m_cached_head - tail;
+        }
+        // points data at the contiguous readable part, returns its size
+        std::size_t peek(const char*& data)
+        {
+            const std::size_t available = readable();
+            const std::size_t index = m_tail.load(std::memory_order_relaxed) & (m_capacity - 1);
+
+            data = m_data.get() + index;
+            return available < m_capacity - index ? available : m_capacity - index;
+        }
+        void consume(const std::size_t n)
+        {
+            m_tail.store(m_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        }
+    };
+}
@@ -1,11 +1,14 @@
 /**
  * util/string_case.hpp - Publicly available code for string case conversion.
+ * ASCII is converted 16 octets at a time (SSE2) regardless of the locale, the other characters of UTF-8 strings
+ * by the simple mappings of Unicode. Invalid UTF-8 is left as it is.
  * */
 
 
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include "globals.hpp"
 
@@ -13,4 +16,8 @@ namespace nnwcli
 {
     DLL_PUBLIC void make_lowercase(std::string& str);
     DLL_PUBLIC void make_uppercase(std::string& str);
+    // simple case folding, the strings which differ only in case fold into the same one
+    DLL_PUBLIC void fold_case(std::string& str);
+    // folds in up to the first delimiter, which has to be ASCII, into out; returns where the delimiter is or n
+    DLL_PUBLIC std::size_t fold_case_until(const char* in, std::size_t n, char delimiter, std::string& out);
 }
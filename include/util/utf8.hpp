@@ -1,5 +1,12 @@
 /**
  * util/utf8.hpp - Publicly available code for reading and writing UTF8 octets.
+ * utf8_validate() checks whole buffers with the lookup table algorithm of Keiser and Lemire,
+ * 32 or 16 octets at a time with AVX2 or SSSE3 when the processor has them, otherwise in scalar code.
+ * Invalid sequences are the ill-formed ones of the Unicode standard, including the overlong forms,
+ * the surrogates and the code points above U+10FFFF.
+ * The bulk conversions between UTF-8, UTF-16 and UTF-32 copy the runs of ASCII 16 at a time (SSE2),
+ * and Utf8View iterates over the code points of a string_view:
+ *     for(const char32_t c : nnwcli::Utf8View(text))
  * */
 
 
@@ -7,7 +14,9 @@
 #pragma once
 
 #include <cstddef>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include "globals.hpp"
 
 
@@ -19,5 +28,127 @@ namespace nnwcli
     };
     DLL_PUBLIC unsigned int utf8_read_octets(const char* in, std::size_t n);
     DLL_PUBLIC char utf8_write_octets(char out[4], unsigned int value);
-    DLL_PUBLIC std::size_t utf8_count_octets(std::string& out);
+    // code points in the string, same as utf8_count_codepoints
+    DLL_PUBLIC std::size_t utf8_count_octets(const std::string& in);
+
+    // what is done with the text that is not valid UTF-8
+    enum EncodingPolicy : unsigned char
+    {
+        // taken as it is
+        EP_PASS_THROUGH = 0,
+        EP_REJECT,
+        // every invalid sequence becomes U+FFFD
+        EP_REPLACE,
+    };
+
+    DLL_PUBLIC bool utf8_validate(const char* in, std::size_t n);
+    DLL_PUBLIC bool utf8_validate(std::string_view in);
+    // offset of the first invalid sequence, n when there is none
+    DLL_PUBLIC std::size_t utf8_find_invalid(const char* in, std::size_t n);
+    // replaces the longest invalid prefix of every invalid sequence with U+FFFD, returns how many were replaced
+    DLL_PUBLIC std::size_t utf8_replace_invalid(std::string& str);
+    // false when the string is not valid and the policy is EP_REJECT
+    DLL_PUBLIC bool utf8_apply_policy(std::string& str, EncodingPolicy policy);
+
+    // octets which are not continuation ones, which is the amount of code points when the string is valid
+    DLL_PUBLIC std::size_t utf8_count_codepoints(const char* in, std::size_t n);
+    DLL_PUBLIC std::size_t utf8_count_codepoints(std::string_view in);
+    /**
+     * Code point at the beginning of in, n must not be 0. Returns the octets it takes;
+     * an invalid sequence gives U+FFFD and the length of its longest valid prefix.
+     * */
+    DLL_PUBLIC std::size_t utf8_decode(const char* in, std::size_t n, char32_t& out);
+
+    //
+    // Bulk conversions. The previous contents of out are replaced.
+    // Invalid UTF-8, unpaired surrogates and values above U+10FFFF throw std::invalid_argument.
+    //
+    DLL_PUBLIC void utf8_to_utf32(std::string_view in, std::u32string& out);
+    DLL_PUBLIC void utf32_to_utf8(std::u32string_view in, std::string& out);
+    DLL_PUBLIC void utf8_to_utf16(std::string_view in, std::u16string& out);
+    DLL_PUBLIC void utf16_to_utf8(std::u16string_view in, std::string& out);
+
+    /**
+     * Code points of a UTF-8 string, which must outlive the view. Never throws:
+     * invalid sequences are given as U+FFFD, the same way utf8_replace_invalid() replaces them.
+     * */
+    class DLL_PUBLIC Utf8View
+    {
+        std::string_view m_text;
+    public:
+        class iterator
+        {
+            const char*     m_pos = nullptr;
+            const char*     m_end = nullptr;
+            char32_t        m_value = 0;
+            std::size_t     m_length = 0;
+
+            void _decode()
+            {
+                if(m_pos == m_end)
+                    m_length = 0;
+                else if(static_cast<unsigned char>(*m_pos) < 0x80)
+                {
+                    m_value = static_cast<unsigned char>(*m_pos);
+                    m_length = 1;
+                }
+                else
+                    m_length = utf8_decode(m_pos, m_end - m_pos, m_value);
+            }
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = char32_t;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const char32_t*;
+            using reference = char32_t;
+
+            iterator() = default;
+            iterator(const char* const pos, const char* const end) : m_pos(pos), m_end(end)
+            {
+                _decode();
+            }
+
+            char32_t operator*() const
+            {
+                return m_value;
+            }
+            iterator& operator++()
+            {
+                m_pos += m_length;
+                _decode();
+                return *this;
+            }
+            iterator operator++(int)
+            {
+                iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+            bool operator==(const iterator& other) const
+            {
+                return m_pos == other.m_pos;
+            }
+            bool operator!=(const iterator& other) const
+            {
+                return m_pos != other.m_pos;
+            }
+            // where the current code point begins
+            const char* get_pos() const
+            {
+                return m_pos;
+            }
+        };
+
+        Utf8View(const std::string_view text) : m_text(text) {}
+
+        iterator begin() const
+        {
+            return iterator(m_text.data(), m_text.data() + m_text.size());
+        }
+        iterator end() const
+        {
+            const char* const end = m_text.data() + m_text.size();
+            return iterator(end, end);
+        }
+    };
 }
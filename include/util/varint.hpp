@@ -0,0 +1,65 @@
+/**
+ * util/varint.hpp - Publicly available code for writing and reading LEB128 variable-length integers.
+ * Signed values are zigzag-encoded first, so that small negative values stay short.
+ * */
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    inline void varint_write(std::string& out, std::uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+    inline void varint_write_signed(std::string& out, const std::int64_t value)
+    {
+        varint_write(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    /**
+     * Reads a varint from in[0..n), returns the amount of octets consumed,
+     * or 0 when the input is truncated or the value does not fit into 64 bits.
+     * */
+    inline std::size_t varint_read(const char* in, const std::size_t n, std::uint64_t& out)
+    {
+        std::uint64_t value = 0;
+
+        for(std::size_t i = 0; i < n && i < 10; i++)
+        {
+            const std::uint64_t octet = static_cast<unsigned char>(in[i]);
+
+            if(i == 9 && octet > 1)
+                return 0;
+            value |= (octet & 0x7F) << (7 * i);
+            if(~octet & 0x80)
+            {
+                out = value;
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+    inline std::size_t varint_read_signed(const char* in, const std::size_t n, std::int64_t& out)
+    {
+        std::uint64_t raw;
+        const std::size_t read = varint_read(in, n, raw);
+
+        if(!read)
+            return 0;
+        out = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+        return read;
+    }
+}
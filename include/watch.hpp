@@ -0,0 +1,100 @@
+/**
+ * watch.hpp - Periodic re-execution of a command, sending only what has changed in its output.
+ *     auto watch = executor.watch("status", context, std::chrono::seconds(1));
+ * Every interval, the line is dispatched into an internal CaptureContext and the output is compared
+ * with the output of the previous run. The differences are written into the target context as records
+ * (see "record.hpp"), so they are rendered by its serializer:
+ *   WD_LINES compares the output line by line, at the same positions:
+ *     "line" {index, text} for every line that is new or different,
+ *     "lines" {count} when the amount of lines has changed.
+ *   WD_CHUNKS compares the hashes of fixed-size chunks of the output:
+ *     "chunk" {offset, data} for every chunk that is new or different,
+ *     "size" {size} when the size of the output has changed.
+ * Nothing is written when the output hasn't changed. The first run sends everything.
+ * The target context is written from the thread of the watch, every run is a single dispatch into it.
+ * Runs never overlap, also those of run_once() called from another thread. When a run throws,
+ * for example because the target can't take the output anymore, the thread stops and keeps the exception.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "capture_context.hpp"
+#include "command_executor.hpp"
+#include "context.hpp"
+#include "globals.hpp"
+
+
+namespace nnwcli
+{
+    class DLL_PUBLIC CommandWatch
+    {
+        CommandExecutor&                m_executor;
+        std::string                     m_line;
+        std::shared_ptr<CommandExecutorContext>
+                                        m_target;
+        std::chrono::milliseconds       m_interval;
+        WatchDiffMode                   m_mode;
+        std::size_t                     m_chunk_size;
+        std::shared_ptr<CaptureContext> m_capture;
+        // output of the previous run and, in the WD_CHUNKS mode, the hashes of its chunks
+        std::pmr::string                m_previous;
+        std::vector<std::uint64_t>      m_previous_hashes;
+        bool                            m_first;
+        std::atomic<std::uint64_t>      m_runs;
+        std::atomic<std::uint64_t>      m_changes;
+        // held across a run, m_capture, m_previous, m_previous_hashes and m_first are only used under it
+        std::mutex                      m_run_mutex;
+
+        mutable std::mutex              m_mutex;
+        std::condition_variable         m_condition;
+        bool                            m_stopping;
+        bool                            m_running;
+        // what has stopped the thread, if it has stopped by itself
+        std::exception_ptr              m_error;
+        std::thread                     m_thread;
+
+        void _diff_lines(std::string_view current);
+        void _diff_chunks(std::string_view current);
+    public:
+        CommandWatch(CommandExecutor& executor, std::string line, std::shared_ptr<CommandExecutorContext> target,
+                std::chrono::milliseconds interval, WatchDiffMode mode = WD_LINES, std::size_t chunk_size = 256);
+        // stops the thread
+        ~CommandWatch();
+        CommandWatch(const CommandWatch&) = delete;
+        CommandWatch& operator=(const CommandWatch&) = delete;
+
+        // starts running the line every interval in a separate thread, again after it has stopped by itself
+        void start();
+        void stop();
+        /**
+         * Runs the line once in the calling thread and writes the differences.
+         * Returns the result of the dispatch.
+         * */
+        DispatchResult run_once();
+
+        // the exception the last run of the thread has thrown, nullptr while it runs
+        std::exception_ptr get_error() const;
+        bool is_running() const;
+
+        const std::string& get_line() const;
+        std::uint64_t get_runs() const;
+        // runs that have written something
+        std::uint64_t get_changes() const;
+    };
+}
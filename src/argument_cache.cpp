@@ -0,0 +1,54 @@
+/**
+ * argument_cache.cpp - Arguments of the running command, accessed by their names instead of in order.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "argument_cache.hpp"
+
+using namespace nnwcli;
+
+// exceptions
+
+const char* unknown_argument::what() const noexcept
+{
+    return "command has no argument with such name";
+}
+
+
+void ArgumentCache::reset(const std::size_t pos)
+{
+    m_starts.clear();
+    m_starts.push_back(pos);
+    for(CustomValue& value : m_values)
+        value.reset();
+}
+bool ArgumentCache::seek(AbstractParser& parser, const std::size_t index)
+{
+    if(m_starts.empty())
+        m_starts.push_back(0);
+    if(index < m_starts.size())
+    {
+        parser.set_pos(m_starts[index]);
+        parser.set_argument_pos(index);
+        return true;
+    }
+
+    parser.set_pos(m_starts.back());
+    parser.set_argument_pos(m_starts.size() - 1);
+    while(m_starts.size() <= index)
+    {
+        if(!parser.skip(false))
+            return false;
+        m_starts.push_back(parser.get_pos());
+    }
+    return true;
+}
+CustomValue& ArgumentCache::get_value(const std::size_t index)
+{
+    if(index >= m_values.size())
+        m_values.resize(index + 1);
+    return m_values[index];
+}
@@ -20,6 +20,17 @@
 
 const char* nnwcli::argtype_to_name(const ArgumentTypes type)
 {
+    static const char* const list_names[] = {
+        "text,...", "tiny int,...", "short int,...", "int,...", "big int,...",
+        "+tiny int,...", "+short int,...", "+int,...", "+big int,...",
+        "float,...", "double float,...", "yes/no,...",
+    };
+
+    if(is_list(type))
+    {
+        const unsigned int element_type = list_element_type(type);
+        return element_type <= CT_BOOL ? list_names[element_type] : "unknown";
+    }
     switch (type)
     {
         case CT_STRING:
@@ -48,8 +59,15 @@ const char* nnwcli::argtype_to_name(const ArgumentTypes type)
             return "yes/no";
         case CT_FULL:
             return "full text...";
+        case CT_PATTERN:
+            return "pattern";
+        case CT_BLOB:
+            return "blob";
         case CT_STRING_CUSTOM:
             return "[predefined]";
+        // the lists are named above
+        case CT_LIST:
+            break;
     }
     return "unknown";
 }
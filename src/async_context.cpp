@@ -0,0 +1,341 @@
+/**
+ * async_context.cpp - Output written into file descriptors by a background thread.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "async_context.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <system_error>
+#include <unistd.h>
+
+using namespace nnwcli;
+
+
+AsyncStream::AsyncStream(AsyncOutputWriter* const writer, const int fd, const std::size_t capacity,
+        const BackpressurePolicy policy) :
+    m_writer(writer), m_ring(capacity), m_fd(fd), m_policy(policy),
+    m_disconnected(false), m_errno(0), m_dropped(0), m_waiting(false) {}
+
+bool AsyncStream::push(const char* data, std::size_t n)
+{
+    if(m_disconnected.load(std::memory_order_acquire))
+    {
+        m_dropped.fetch_add(n, std::memory_order_relaxed);
+        return false;
+    }
+    if(!m_ring.try_write(data, n))
+    {
+        if(m_policy == BP_DROP)
+        {
+            m_dropped.fetch_add(n, std::memory_order_relaxed);
+            return false;
+        }
+        if(m_policy == BP_DISCONNECT)
+        {
+            m_dropped.fetch_add(n, std::memory_order_relaxed);
+            disconnect();
+            return false;
+        }
+
+        // BP_BLOCK, output larger than the ring goes in pieces
+        while(n)
+        {
+            const std::size_t written = m_ring.write_some(data, n);
+            data += written;
+            n -= written;
+            if(!n)
+                break;
+
+            m_writer->_wake();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiting.store(true);
+            // the timeout covers a wakeup that happened before m_waiting was seen by the writer
+            m_condition.wait_for(lock, std::chrono::milliseconds(10), [this]()
+                    { return m_ring.writable() || m_disconnected.load(); });
+            m_waiting.store(false);
+            if(m_disconnected.load())
+            {
+                m_dropped.fetch_add(n, std::memory_order_relaxed);
+                return false;
+            }
+        }
+    }
+    m_writer->_wake();
+    return true;
+}
+void AsyncStream::disconnect(const int error)
+{
+    if(error)
+        m_errno.store(error);
+    m_disconnected.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_condition.notify_all();
+}
+bool AsyncStream::wait_drained(const std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_waiting.store(true);
+    // short slices, for the same reason as in push()
+    while(!m_disconnected.load() && m_ring.size())
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if(now >= deadline)
+        {
+            m_waiting.store(false);
+            return false;
+        }
+        m_condition.wait_for(lock, std::min<std::chrono::steady_clock::duration>(
+                deadline - now, std::chrono::milliseconds(10)));
+    }
+    m_waiting.store(false);
+    return true;
+}
+int AsyncStream::get_fd() const
+{
+    return m_fd;
+}
+BackpressurePolicy AsyncStream::get_policy() const
+{
+    return m_policy;
+}
+bool AsyncStream::is_disconnected() const
+{
+    return m_disconnected.load();
+}
+int AsyncStream::get_errno() const
+{
+    return m_errno.load();
+}
+std::uint64_t AsyncStream::get_dropped_bytes() const
+{
+    return m_dropped.load();
+}
+std::size_t AsyncStream::get_pending() const
+{
+    return m_ring.size();
+}
+
+
+AsyncOutputWriter::AsyncOutputWriter(const std::chrono::milliseconds linger) :
+    m_version(0), m_sleeping(false), m_stopping(false), m_linger(linger)
+{
+    if(::pipe(m_wake) < 0)
+        throw std::system_error(errno, std::generic_category());
+    ::fcntl(m_wake[0], F_SETFL, ::fcntl(m_wake[0], F_GETFL) | O_NONBLOCK);
+    ::fcntl(m_wake[1], F_SETFL, ::fcntl(m_wake[1], F_GETFL) | O_NONBLOCK);
+    m_thread = std::thread(&AsyncOutputWriter::_run, this);
+}
+AsyncOutputWriter::~AsyncOutputWriter()
+{
+    m_stopping.store(true);
+    m_sleeping.store(true);
+    _wake();
+    m_thread.join();
+    ::close(m_wake[0]);
+    ::close(m_wake[1]);
+}
+std::shared_ptr<AsyncStream> AsyncOutputWriter::open(
+        const int fd, const std::size_t capacity, const BackpressurePolicy policy)
+{
+    auto stream = std::make_shared<AsyncStream>(this, fd, capacity, policy);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_descriptors.find(fd);
+
+    if(found == m_descriptors.end())
+    {
+        // the file description is shared with every other user of the descriptor
+        const int flags = ::fcntl(fd, F_GETFL);
+        if(flags >= 0 && !(flags & O_NONBLOCK))
+            ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        found = m_descriptors.emplace(fd, _Descriptor{flags, 0}).first;
+    }
+    found->second.m_streams++;
+    m_streams.push_back(stream);
+    m_version.fetch_add(1);
+    return stream;
+}
+std::size_t AsyncOutputWriter::get_stream_count()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_streams.size();
+}
+void AsyncOutputWriter::_release_descriptor(const int fd)
+{
+    auto found = m_descriptors.find(fd);
+
+    if(found == m_descriptors.end() || --found->second.m_streams)
+        return;
+    // only the flag set by open(), the others could have been changed meanwhile
+    if(found->second.m_flags >= 0 && !(found->second.m_flags & O_NONBLOCK))
+    {
+        const int flags = ::fcntl(fd, F_GETFL);
+        if(flags >= 0)
+            ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    m_descriptors.erase(found);
+}
+void AsyncOutputWriter::_wake()
+{
+    // only a sleeping thread needs the syscall
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_sleeping.exchange(false))
+    {
+        const char octet = 0;
+        while(::write(m_wake[1], &octet, 1) < 0 && errno == EINTR);
+    }
+}
+bool AsyncOutputWriter::_drain(AsyncStream& stream)
+{
+    const char* data;
+    std::size_t n;
+    bool consumed = false;
+
+    while((n = stream.m_ring.peek(data)))
+    {
+        if(stream.m_disconnected.load(std::memory_order_relaxed))
+        {
+            // nobody is going to read it
+            stream.m_ring.consume(n);
+            consumed = true;
+            continue;
+        }
+        const ssize_t written = ::write(stream.m_fd, data, n);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                stream.disconnect(errno);
+                continue;
+            }
+            break;
+        }
+        stream.m_ring.consume(written);
+        consumed = true;
+    }
+    if(consumed && stream.m_waiting.load())
+    {
+        {
+            std::lock_guard<std::mutex> lock(stream.m_mutex);
+        }
+        stream.m_condition.notify_all();
+    }
+    return n != 0;
+}
+void AsyncOutputWriter::_run()
+{
+    std::vector<std::shared_ptr<AsyncStream>> streams;
+    std::vector<struct pollfd> pollfds;
+    std::uint64_t version = ~static_cast<std::uint64_t>(0);
+    std::vector<AsyncStream*> orphans;
+    std::chrono::steady_clock::time_point deadline;
+    bool stopping = false;
+    sigset_t sigpipe;
+
+    // a consumer that has gone away shows up as EPIPE instead of killing the process
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+    while(true)
+    {
+        if(version != m_version.load())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            version = m_version.load();
+            streams = m_streams;
+        }
+
+        // write what can be written without waiting, poll the rest
+        pollfds.clear();
+        pollfds.push_back({m_wake[0], POLLIN, 0});
+        orphans.clear();
+        for(const auto& stream : streams)
+        {
+            if(_drain(*stream))
+                pollfds.push_back({stream->m_fd, POLLOUT, 0});
+            // the copy here and the one in m_streams
+            else if(stream.use_count() <= 2)
+                orphans.push_back(stream.get());
+        }
+        if(!orphans.empty())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(auto it = m_streams.begin(); it != m_streams.end();)
+            {
+                const std::shared_ptr<AsyncStream>& stream = *it;
+                if(std::find(orphans.begin(), orphans.end(), stream.get()) != orphans.end() &&
+                        stream.use_count() <= 2 && !stream->m_ring.readable())
+                {
+                    _release_descriptor(stream->m_fd);
+                    it = m_streams.erase(it);
+                }
+                else
+                    it++;
+            }
+            m_version.fetch_add(1);
+        }
+
+        if(!stopping && m_stopping.load())
+        {
+            stopping = true;
+            deadline = std::chrono::steady_clock::now() + m_linger;
+        }
+        if(stopping && (pollfds.size() == 1 || std::chrono::steady_clock::now() >= deadline))
+            break;
+
+        // nothing is written into the rings while sleeping, otherwise _wake() interrupts poll()
+        m_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(pollfds.size() == 1 && (version != m_version.load() ||
+                std::any_of(streams.begin(), streams.end(), [](const std::shared_ptr<AsyncStream>& stream)
+                    { return stream->m_ring.readable() != 0; })))
+        {
+            m_sleeping.store(false);
+            continue;
+        }
+        ::poll(pollfds.data(), pollfds.size(), stopping ? 10 : -1);
+        m_sleeping.store(false);
+
+        char discard[64];
+        while(::read(m_wake[0], discard, sizeof(discard)) > 0);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(const auto& stream : m_streams)
+    {
+        stream->disconnect();
+        _release_descriptor(stream->m_fd);
+    }
+}
+
+
+AsyncContext::AsyncContext(AsyncOutputWriter& writer, const int fd, const BackpressurePolicy policy,
+        const std::size_t capacity, const std::size_t high_water) :
+    BufferedContext(high_water), m_stream(writer.open(fd, capacity, policy)) {}
+
+void AsyncContext::sink(const char* const data, const std::size_t n)
+{
+    m_stream->push(data, n);
+}
+const std::shared_ptr<AsyncStream>& AsyncContext::get_stream() const
+{
+    return m_stream;
+}
+
+#endif
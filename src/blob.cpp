@@ -0,0 +1,235 @@
+/**
+ * blob.cpp - Decoding of the CT_BLOB arguments, which carry arbitrary octets.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "blob.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNWCLI_BLOB_SSE2
+#endif
+
+using namespace nnwcli;
+
+
+static constexpr std::string_view __hex_prefix = "hex:";
+static constexpr std::string_view __base64_prefix = "b64:";
+
+// value of every octet as a digit, -1 for the octets that are not digits
+struct __DigitTable
+{
+    std::array<std::int8_t, 256> m_values;
+
+    constexpr __DigitTable(const std::string_view digits) : m_values()
+    {
+        for(std::size_t i = 0; i < m_values.size(); i++)
+            m_values[i] = -1;
+        for(std::size_t i = 0; i < digits.size(); i++)
+            m_values[static_cast<unsigned char>(digits[i])] = static_cast<std::int8_t>(i);
+    }
+    constexpr int operator[](const char c) const
+    {
+        return m_values[static_cast<unsigned char>(c)];
+    }
+};
+static constexpr __DigitTable __base64_digits("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+static constexpr __DigitTable __hex_lower_digits("0123456789abcdef");
+static constexpr __DigitTable __hex_upper_digits("0123456789ABCDEF");
+
+static int __hex_digit(const char c)
+{
+    const int value = __hex_lower_digits[c];
+
+    if(value >= 0)
+        return value;
+    return __hex_upper_digits[c];
+}
+static int __base64_digit(const char c)
+{
+    const int value = __base64_digits[c];
+
+    if(value < 0)
+        throw std::invalid_argument("blob has an invalid base64 character");
+    return value;
+}
+// the padding is only allowed to complete the last group
+static std::string_view __strip_padding(std::string_view text)
+{
+    if(text.size() % 4 == 0)
+    {
+        for(int i = 0; i < 2 && !text.empty() && text.back() == '='; i++)
+            text.remove_suffix(1);
+    }
+    return text;
+}
+
+#ifdef NNWCLI_BLOB_SSE2
+static __m128i __in_range(const __m128i chunk, const char low, const char high)
+{
+    // octets above 0x7F are negative, so they are never in range
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8(high + 1)));
+}
+// 16 hexadecimal digits into 8 octets, false when some of them are not digits
+static bool __decode_hex16(const char* const in, std::uint8_t* const out)
+{
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const __m128i digits = __in_range(chunk, '0', '9');
+    const __m128i upper = __in_range(chunk, 'A', 'F');
+    const __m128i lower = __in_range(chunk, 'a', 'f');
+
+    if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digits, upper), lower)) != 0xFFFF)
+        return false;
+
+    const __m128i offsets = _mm_or_si128(_mm_or_si128(
+            _mm_and_si128(digits, _mm_set1_epi8(-'0')),
+            _mm_and_si128(upper, _mm_set1_epi8(10 - 'A'))),
+            _mm_and_si128(lower, _mm_set1_epi8(10 - 'a')));
+    const __m128i values = _mm_add_epi8(chunk, offsets);
+    // the first digit of a pair is in the low octet of a 16-bit lane
+    const __m128i high = _mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4);
+    const __m128i octets = _mm_or_si128(high, _mm_srli_epi16(values, 8));
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(octets, octets));
+    return true;
+}
+// 16 base64 digits into 12 octets, false when some of them are not digits
+static bool __decode_base64_16(const char* const in, std::uint8_t* const out)
+{
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const __m128i upper = __in_range(chunk, 'A', 'Z');
+    const __m128i lower = __in_range(chunk, 'a', 'z');
+    const __m128i digits = __in_range(chunk, '0', '9');
+    const __m128i plus = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/'));
+
+    if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digits, plus)), slash)) != 0xFFFF)
+        return false;
+
+    const __m128i offsets = _mm_or_si128(_mm_or_si128(_mm_or_si128(
+            _mm_and_si128(upper, _mm_set1_epi8(-'A')),
+            _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+            _mm_or_si128(_mm_and_si128(digits, _mm_set1_epi8(52 - '0')), _mm_and_si128(plus, _mm_set1_epi8(62 - '+')))),
+            _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    const __m128i values = _mm_add_epi8(chunk, offsets);
+    // pairs of digits into 12 bits, then pairs of those into the 24 bits of a group
+    const __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 6),
+            _mm_srli_epi16(values, 8));
+    const __m128i groups = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0xFFFF)), 12),
+            _mm_srli_epi32(pairs, 16));
+    std::uint32_t words[4];
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(words), groups);
+    for(int i = 0; i < 4; i++)
+    {
+        out[i * 3] = static_cast<std::uint8_t>(words[i] >> 16);
+        out[i * 3 + 1] = static_cast<std::uint8_t>(words[i] >> 8);
+        out[i * 3 + 2] = static_cast<std::uint8_t>(words[i]);
+    }
+    return true;
+}
+#endif
+
+
+std::size_t nnwcli::hex_decoded_size(const std::string_view text)
+{
+    if(text.size() % 2)
+        throw std::invalid_argument("blob has an odd number of hexadecimal digits");
+    return text.size() / 2;
+}
+std::size_t nnwcli::decode_hex(const std::string_view text, std::uint8_t* const out)
+{
+    const std::size_t size = hex_decoded_size(text);
+    const char* const in = text.data();
+    std::size_t i = 0;
+
+#ifdef NNWCLI_BLOB_SSE2
+    // an invalid chunk is left to the scalar loop, which finds the wrong character
+    while(i + 8 <= size && __decode_hex16(in + i * 2, out + i))
+        i += 8;
+#endif
+    for(; i < size; i++)
+    {
+        const int high = __hex_digit(in[i * 2]);
+        const int low = __hex_digit(in[i * 2 + 1]);
+
+        if(high < 0 || low < 0)
+            throw std::invalid_argument("blob has an invalid hexadecimal digit");
+        out[i] = static_cast<std::uint8_t>(high << 4 | low);
+    }
+    return size;
+}
+std::size_t nnwcli::base64_decoded_size(std::string_view text)
+{
+    text = __strip_padding(text);
+    if(text.size() % 4 == 1)
+        throw std::invalid_argument("blob has a truncated base64 group");
+    return text.size() / 4 * 3 + (text.size() % 4 ? text.size() % 4 - 1 : 0);
+}
+std::size_t nnwcli::decode_base64(std::string_view text, std::uint8_t* const out)
+{
+    const std::size_t size = base64_decoded_size(text);
+    text = __strip_padding(text);
+    const char* in = text.data();
+    const char* const end = in + text.size();
+    std::uint8_t* o = out;
+
+#ifdef NNWCLI_BLOB_SSE2
+    while(end - in >= 16 && __decode_base64_16(in, o))
+    {
+        in += 16;
+        o += 12;
+    }
+#endif
+    for(; end - in >= 4; in += 4, o += 3)
+    {
+        const std::uint32_t group = __base64_digit(in[0]) << 18 | __base64_digit(in[1]) << 12 |
+            __base64_digit(in[2]) << 6 | __base64_digit(in[3]);
+
+        o[0] = static_cast<std::uint8_t>(group >> 16);
+        o[1] = static_cast<std::uint8_t>(group >> 8);
+        o[2] = static_cast<std::uint8_t>(group);
+    }
+    // the unused bits of a shortened group are ignored
+    if(end - in >= 2)
+    {
+        std::uint32_t group = __base64_digit(in[0]) << 18 | __base64_digit(in[1]) << 12;
+
+        if(end - in == 3)
+            group |= __base64_digit(in[2]) << 6;
+        *o++ = static_cast<std::uint8_t>(group >> 16);
+        if(end - in == 3)
+            *o++ = static_cast<std::uint8_t>(group >> 8);
+    }
+    return size;
+}
+std::size_t nnwcli::blob_decoded_size(const std::string_view text)
+{
+    if(text.substr(0, __hex_prefix.size()) == __hex_prefix)
+        return hex_decoded_size(text.substr(__hex_prefix.size()));
+    if(text.substr(0, __base64_prefix.size()) == __base64_prefix)
+        return base64_decoded_size(text.substr(__base64_prefix.size()));
+    return text.size();
+}
+std::size_t nnwcli::decode_blob(const std::string_view text, std::uint8_t* const buffer, const std::size_t capacity)
+{
+    if(blob_decoded_size(text) > capacity)
+        throw std::out_of_range("blob is too large");
+    if(text.substr(0, __hex_prefix.size()) == __hex_prefix)
+        return decode_hex(text.substr(__hex_prefix.size()), buffer);
+    if(text.substr(0, __base64_prefix.size()) == __base64_prefix)
+        return decode_base64(text.substr(__base64_prefix.size()), buffer);
+    if(!text.empty())
+        std::memcpy(buffer, text.data(), text.size());
+    return text.size();
+}
+void nnwcli::decode_blob(const std::string_view text, std::vector<std::uint8_t>& out)
+{
+    out.resize(blob_decoded_size(text));
+    out.resize(decode_blob(text, out.data(), out.size()));
+}
@@ -0,0 +1,212 @@
+/**
+ * broadcast_context.cpp - Output of a command mirrored to any amount of subscribers.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "broadcast_context.hpp"
+#include <algorithm>
+#include <utility>
+
+using namespace nnwcli;
+
+
+BroadcastSubscriber::BroadcastSubscriber(std::shared_ptr<BroadcastHub> hub, const std::size_t max_pending,
+        const SubscriberPolicy policy) :
+    m_hub(std::move(hub)), m_next(0), m_next_offset(0), m_max_pending(max_pending), m_policy(policy),
+    m_disconnected(false), m_dropped_bytes(0) {}
+
+BroadcastSubscriber::~BroadcastSubscriber()
+{
+    std::lock_guard<std::mutex> lock(m_hub->m_mutex);
+    auto& subscribers = m_hub->m_subscribers;
+
+    subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), this), subscribers.end());
+}
+std::size_t BroadcastSubscriber::poll(
+        std::vector<std::shared_ptr<const BroadcastChunk>>& out, const std::size_t max_chunks)
+{
+    std::lock_guard<std::mutex> lock(m_hub->m_mutex);
+    std::size_t count = 0;
+
+    m_hub->_catch_up(*this);
+    if(m_disconnected)
+        return 0;
+
+    const auto& log = m_hub->m_log;
+    while(m_next < m_hub->m_next_sequence && (!max_chunks || count < max_chunks))
+    {
+        const auto& chunk = log[m_next - log.front()->m_sequence];
+        out.push_back(chunk);
+        m_next++;
+        m_next_offset = chunk->m_offset + chunk->m_data.size();
+        count++;
+    }
+    return count;
+}
+bool BroadcastSubscriber::wait(const std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_hub->m_mutex);
+
+    return m_hub->m_condition.wait_for(lock, timeout, [this]()
+            { return m_disconnected || m_next < m_hub->m_next_sequence; });
+}
+std::size_t BroadcastSubscriber::get_pending_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_hub->m_mutex);
+    return m_disconnected ? 0 : m_hub->m_published_bytes - m_next_offset;
+}
+std::uint64_t BroadcastSubscriber::get_dropped_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_hub->m_mutex);
+    return m_dropped_bytes;
+}
+bool BroadcastSubscriber::is_disconnected() const
+{
+    std::lock_guard<std::mutex> lock(m_hub->m_mutex);
+    return m_disconnected;
+}
+SubscriberPolicy BroadcastSubscriber::get_policy() const
+{
+    return m_policy;
+}
+
+
+BroadcastHub::BroadcastHub(const std::size_t max_log_bytes) :
+    m_next_sequence(0), m_published_bytes(0), m_log_bytes(0), m_max_log_bytes(max_log_bytes), m_since_trim(0) {}
+
+void BroadcastHub::_trim_front()
+{
+    // the latest chunk stays, so that it reaches at least the subscribers that keep up
+    while(m_log_bytes > m_max_log_bytes && m_log.size() > 1)
+    {
+        m_log_bytes -= m_log.front()->m_data.size();
+        m_log.pop_front();
+    }
+}
+void BroadcastHub::_trim_consumed()
+{
+    std::uint64_t slowest = m_next_sequence;
+
+    for(const BroadcastSubscriber* const subscriber : m_subscribers)
+    {
+        if(!subscriber->m_disconnected)
+            slowest = std::min(slowest, subscriber->m_next);
+    }
+    while(!m_log.empty() && m_log.front()->m_sequence < slowest)
+    {
+        m_log_bytes -= m_log.front()->m_data.size();
+        m_log.pop_front();
+    }
+    m_since_trim = 0;
+}
+void BroadcastHub::_catch_up(BroadcastSubscriber& subscriber)
+{
+    const std::uint64_t first = m_log.empty() ? m_next_sequence : m_log.front()->m_sequence;
+    const bool lost = subscriber.m_next < first;
+
+    if(subscriber.m_disconnected ||
+            (!lost && m_published_bytes - subscriber.m_next_offset <= subscriber.m_max_pending))
+        return;
+
+    std::uint64_t target = std::max(subscriber.m_next, first);
+    switch(subscriber.m_policy)
+    {
+    case SP_DISCONNECT:
+        subscriber.m_disconnected = true;
+        target = m_next_sequence;
+        break;
+    case SP_SKIP_TO_LATEST:
+        target = m_log.empty() ? m_next_sequence : m_log.back()->m_sequence;
+        break;
+    case SP_DROP_OLDEST:
+        while(target < m_next_sequence &&
+                m_published_bytes - m_log[target - first]->m_offset > subscriber.m_max_pending)
+            target++;
+        break;
+    }
+
+    const std::uint64_t offset = target < m_next_sequence ? m_log[target - first]->m_offset : m_published_bytes;
+    subscriber.m_dropped_bytes += offset - subscriber.m_next_offset;
+    subscriber.m_next = target;
+    subscriber.m_next_offset = offset;
+}
+std::shared_ptr<BroadcastSubscriber> BroadcastHub::subscribe(
+        const std::size_t max_pending, const SubscriberPolicy policy)
+{
+    auto subscriber = std::make_shared<BroadcastSubscriber>(shared_from_this(), max_pending, policy);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    subscriber->m_next = m_next_sequence;
+    subscriber->m_next_offset = m_published_bytes;
+    m_subscribers.push_back(subscriber.get());
+    return subscriber;
+}
+void BroadcastHub::publish(const char* const data, const std::size_t n)
+{
+    publish(std::string(data, n));
+}
+void BroadcastHub::publish(std::string data)
+{
+    // the only copy of the output is made outside of the lock
+    auto chunk = std::make_shared<BroadcastChunk>();
+    chunk->m_data = std::move(data);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        chunk->m_sequence = m_next_sequence++;
+        chunk->m_offset = m_published_bytes;
+        m_published_bytes += chunk->m_data.size();
+        m_log_bytes += chunk->m_data.size();
+        m_log.push_back(std::move(chunk));
+
+        // finding the slowest cursor costs a pass over the subscribers, so it is done once in a while
+        if(++m_since_trim >= 16)
+            _trim_consumed();
+        _trim_front();
+    }
+    m_condition.notify_all();
+}
+std::size_t BroadcastHub::get_subscriber_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_subscribers.size();
+}
+std::size_t BroadcastHub::get_log_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_log_bytes;
+}
+std::uint64_t BroadcastHub::get_published_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_published_bytes;
+}
+
+
+BroadcastContext::BroadcastContext(std::shared_ptr<BroadcastHub> hub, const std::size_t high_water) :
+    BufferedContext(high_water), m_hub(std::move(hub)) {}
+
+void BroadcastContext::sink(const char* const data, const std::size_t n)
+{
+    m_hub->publish(data, n);
+}
+void BroadcastContext::sinkv(const OutputFragment* const fragments, const std::size_t count)
+{
+    // the whole chain becomes a single chunk
+    std::size_t size = 0;
+    for(std::size_t i = 0; i < count; i++)
+        size += fragments[i].m_size;
+
+    std::string data;
+    data.reserve(size);
+    for(std::size_t i = 0; i < count; i++)
+        data.append(fragments[i].m_data, fragments[i].m_size);
+    m_hub->publish(std::move(data));
+}
+const std::shared_ptr<BroadcastHub>& BroadcastContext::get_hub() const
+{
+    return m_hub;
+}
@@ -0,0 +1,184 @@
+/**
+ * buffered_context.cpp - Context that accumulates the output of a command in memory.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "buffered_context.hpp"
+#include <algorithm>
+#include <cstdio>
+
+using namespace nnwcli;
+
+
+BufferedContext::BufferedContext(const std::size_t high_water, std::pmr::memory_resource* const resource) :
+    m_buffer(resource), m_high_water(high_water), m_coalescing(true), m_dispatch_depth(0),
+    m_output_mode(OM_COPY), m_copy_threshold(16), m_fragments(resource), m_referenced_size(0),
+    m_chain(resource), m_reserved(0) {}
+
+void BufferedContext::sinkv(const OutputFragment* const fragments, const std::size_t count)
+{
+    for(std::size_t i = 0; i < count; i++)
+        sink(fragments[i].m_data, fragments[i].m_size);
+}
+void BufferedContext::drain()
+{
+    if(m_fragments.empty())
+    {
+        if(m_buffer.empty())
+            return;
+        sink(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+        return;
+    }
+
+    // the arena could have been reallocated, so its fragments are resolved only now
+    m_chain.clear();
+    for(const _Fragment& fragment : m_fragments)
+    {
+        if(fragment.m_data)
+            m_chain.push_back({fragment.m_data, fragment.m_size});
+        else
+            m_chain.push_back({m_buffer.data() + fragment.m_offset, fragment.m_size});
+    }
+    m_fragments.clear();
+    m_referenced_size = 0;
+    try
+    {
+        sinkv(m_chain.data(), m_chain.size());
+    }
+    catch(...)
+    {
+        m_buffer.clear();
+        throw;
+    }
+    m_buffer.clear();
+}
+void BufferedContext::_appended(const std::size_t offset, const std::size_t n)
+{
+    count_output(n);
+    if(m_output_mode == OM_SCATTER && n)
+    {
+        // extend the last fragment if it ends where the new data starts
+        if(!m_fragments.empty() && !m_fragments.back().m_data &&
+                m_fragments.back().m_offset + m_fragments.back().m_size == offset)
+            m_fragments.back().m_size += n;
+        else
+            m_fragments.push_back({nullptr, offset, n});
+    }
+    if(m_buffer.size() >= m_high_water || m_fragments.size() >= max_fragments)
+        drain();
+}
+void BufferedContext::write(const char* const data, const std::size_t n)
+{
+    const std::size_t offset = m_buffer.size();
+
+    m_buffer.append(data, n);
+    _appended(offset, n);
+}
+void BufferedContext::write_ref(const char* const data, const std::size_t n)
+{
+    if(m_output_mode != OM_SCATTER || n < m_copy_threshold)
+    {
+        write(data, n);
+        return;
+    }
+
+    count_output(n);
+    m_fragments.push_back({data, 0, n});
+    m_referenced_size += n;
+    if(m_fragments.size() >= max_fragments)
+        drain();
+}
+char* BufferedContext::output_reserve(const std::size_t n)
+{
+    m_reserved = m_buffer.size();
+    m_buffer.resize(m_reserved + n);
+    return &m_buffer[m_reserved];
+}
+void BufferedContext::output_commit(const std::size_t size)
+{
+    m_buffer.resize(m_reserved + size);
+    _appended(m_reserved, size);
+}
+void BufferedContext::write(const std::string& data)
+{
+    write(data.data(), data.size());
+}
+void BufferedContext::vnprintf(const char* const format, const std::size_t n, va_list args)
+{
+    if(!n)
+        return;
+
+    // format right into the buffer, n includes the null terminator
+    const std::size_t old_size = m_buffer.size();
+    m_buffer.resize(old_size + n);
+    const int written = std::vsnprintf(&m_buffer[old_size], n, format, args);
+    const std::size_t size = written > 0 ? std::min<std::size_t>(written, n - 1) : 0;
+    m_buffer.resize(old_size + size);
+    _appended(old_size, size);
+}
+void BufferedContext::vnprintf(const std::string& format, const std::size_t n, va_list args)
+{
+    vnprintf(format.c_str(), n, args);
+}
+void BufferedContext::flush()
+{
+    // the executor will drain the buffer at the end of the dispatch,
+    // unless it references the data the command may free once it has flushed
+    if(m_coalescing && m_dispatch_depth && !m_referenced_size)
+        return;
+    drain();
+}
+void BufferedContext::begin_dispatch()
+{
+    m_dispatch_depth++;
+}
+void BufferedContext::end_dispatch()
+{
+    if(m_dispatch_depth)
+        m_dispatch_depth--;
+    if(!m_dispatch_depth)
+        drain();
+}
+std::size_t BufferedContext::get_high_water() const
+{
+    return m_high_water;
+}
+void BufferedContext::set_high_water(const std::size_t high_water)
+{
+    m_high_water = high_water;
+}
+bool BufferedContext::is_coalescing() const
+{
+    return m_coalescing;
+}
+void BufferedContext::set_coalescing(const bool coalescing)
+{
+    m_coalescing = coalescing;
+}
+std::size_t BufferedContext::get_buffered_size() const
+{
+    return m_buffer.size() + m_referenced_size;
+}
+BufferedContext::OutputMode BufferedContext::get_output_mode() const
+{
+    return m_output_mode;
+}
+void BufferedContext::set_output_mode(const OutputMode mode)
+{
+    if(mode == m_output_mode)
+        return;
+    drain();
+    m_output_mode = mode;
+}
+std::size_t BufferedContext::get_copy_threshold() const
+{
+    return m_copy_threshold;
+}
+void BufferedContext::set_copy_threshold(const std::size_t threshold)
+{
+    m_copy_threshold = threshold;
+}
@@ -0,0 +1,143 @@
+/**
+ * capture_context.cpp - Context that keeps the output of the commands for the code that called them.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "capture_context.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+using namespace nnwcli;
+
+
+CaptureContext::CaptureContext(const std::size_t chunk_size, std::pmr::memory_resource* const resource) :
+    m_chunks(resource), m_chunk_size(chunk_size ? chunk_size : 1), m_size(0), m_reserved(0) {}
+
+std::pmr::string& CaptureContext::_room_for(const std::size_t n)
+{
+    if(!m_chunks.empty() && m_chunks.back().capacity() - m_chunks.back().size() >= n)
+        return m_chunks.back();
+
+    // an empty chunk left by reset() is replaced rather than followed
+    std::size_t capacity = m_chunk_size;
+    if(!m_chunks.empty())
+        capacity = std::max(capacity, m_chunks.back().capacity() * 2);
+    if(!m_chunks.empty() && m_chunks.back().empty())
+        m_chunks.pop_back();
+    m_chunks.emplace_back();
+    m_chunks.back().reserve(std::max(capacity, n));
+    return m_chunks.back();
+}
+void CaptureContext::_join()
+{
+    if(m_chunks.size() < 2)
+        return;
+
+    std::pmr::string joined(m_chunks.get_allocator());
+    joined.reserve(m_size);
+    for(const std::pmr::string& chunk : m_chunks)
+        joined.append(chunk);
+    m_chunks.clear();
+    m_chunks.push_back(std::move(joined));
+}
+void CaptureContext::write(const char* const data, const std::size_t n)
+{
+    if(!n)
+        return;
+    _room_for(n).append(data, n);
+    m_size += n;
+    count_output(n);
+}
+void CaptureContext::write(const std::string& data)
+{
+    write(data.data(), data.size());
+}
+char* CaptureContext::output_reserve(const std::size_t n)
+{
+    std::pmr::string& chunk = _room_for(n);
+
+    // stays within the capacity, so nothing is reallocated
+    m_reserved = chunk.size();
+    chunk.resize(m_reserved + n);
+    return &chunk[m_reserved];
+}
+void CaptureContext::output_commit(const std::size_t size)
+{
+    m_chunks.back().resize(m_reserved + size);
+    m_size += size;
+    count_output(size);
+}
+void CaptureContext::vnprintf(const char* const format, const std::size_t n, va_list args)
+{
+    if(!n)
+        return;
+
+    std::pmr::string& chunk = _room_for(n);
+    const std::size_t offset = chunk.size();
+    chunk.resize(offset + n);
+    const int written = std::vsnprintf(&chunk[offset], n, format, args);
+    const std::size_t size = written > 0 ? std::min<std::size_t>(written, n - 1) : 0;
+    chunk.resize(offset + size);
+    m_size += size;
+    count_output(size);
+}
+void CaptureContext::vnprintf(const std::string& format, const std::size_t n, va_list args)
+{
+    vnprintf(format.c_str(), n, args);
+}
+void CaptureContext::flush() {}
+
+std::string_view CaptureContext::view()
+{
+    _join();
+    if(m_chunks.empty())
+        return std::string_view();
+    return m_chunks.front();
+}
+std::pmr::string CaptureContext::take()
+{
+    _join();
+    if(m_chunks.empty())
+        return std::pmr::string(m_chunks.get_allocator());
+
+    std::pmr::string result = std::move(m_chunks.front());
+    m_chunks.clear();
+    m_size = 0;
+    return result;
+}
+void CaptureContext::reset()
+{
+    if(!m_chunks.empty())
+    {
+        auto largest = std::max_element(m_chunks.begin(), m_chunks.end(),
+                [](const std::pmr::string& a, const std::pmr::string& b) { return a.capacity() < b.capacity(); });
+        std::pmr::string kept = std::move(*largest);
+        kept.clear();
+        m_chunks.clear();
+        m_chunks.push_back(std::move(kept));
+    }
+    m_size = 0;
+}
+std::size_t CaptureContext::size() const
+{
+    return m_size;
+}
+bool CaptureContext::empty() const
+{
+    return !m_size;
+}
+std::size_t CaptureContext::get_chunk_count() const
+{
+    // the chunk kept by reset() doesn't count until something is written into it
+    if(m_chunks.size() == 1 && m_chunks.front().empty())
+        return 0;
+    return m_chunks.size();
+}
+std::string_view CaptureContext::get_chunk(const std::size_t index) const
+{
+    return m_chunks[index];
+}
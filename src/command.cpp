@@ -16,6 +16,8 @@
 
 #include "command.hpp"
 #include "argument_types.hpp"
+#include <memory>
+#include "parser/abstract_parser.hpp"
 #include <utility>
 
 using namespace nnwcli;
@@ -33,6 +35,14 @@ std::size_t Command::get_optargs_count() const
 {
     return m_optargs.size();
 }
+std::size_t Command::get_options_count() const
+{
+    return m_options.size();
+}
+const OptionIndex& Command::get_option_index() const
+{
+    return m_option_index;
+}
 const std::string& Command::get_description() const
 {
     return m_description;
@@ -53,6 +63,40 @@ void Command::set_description(const char* description)
 {
     m_description = description;
 }
+static void __resolve_argument_type(ArgumentDefinition& arg, const TypeRegistry& registry)
+{
+    if(arg.m_type == CT_STRING_CUSTOM)
+    {
+        arg.m_custom_id = registry.find(arg.m_parameter);
+        if(!arg.m_custom_id)
+            throw unknown_custom_type();
+    }
+    else if(arg.m_type == CT_PATTERN && (!arg.m_pattern || arg.m_pattern->get_source() != arg.m_parameter))
+        arg.m_pattern = std::make_shared<const Pattern>(arg.m_parameter);
+}
+void Command::resolve_argument_types(const TypeRegistry& registry)
+{
+    for(std::vector<ArgumentDefinition>* const args : {&m_args, &m_optargs})
+    {
+        for(ArgumentDefinition& arg : *args)
+            __resolve_argument_type(arg, registry);
+    }
+    for(OptionDefinition& option : m_options)
+        __resolve_argument_type(option, registry);
+
+    // the options end where the text of a CT_FULL argument begins
+    std::size_t full_position = OptionIndex::npos, position = 0;
+    for(const std::vector<ArgumentDefinition>* const args : {&m_args, &m_optargs})
+    {
+        for(const ArgumentDefinition& arg : *args)
+        {
+            if(arg.m_type == CT_FULL && full_position == OptionIndex::npos)
+                full_position = position;
+            position++;
+        }
+    }
+    m_option_index.build(m_options, full_position);
+}
 const bool Command::operator< (const Command&& other) const
 {
     return m_name < other.m_name;
@@ -64,6 +108,11 @@ std::vector<std::string> Command::tab_complete(
     return {};
 }
 
+bool Command::is_concurrent() const
+{
+    return false;
+}
+
 std::pair<std::vector<ArgumentDefinition>::const_iterator,
           std::vector<ArgumentDefinition>::const_iterator>
 Command::get_arg_iter() const
@@ -76,6 +125,70 @@ Command::get_optarg_iter() const
 {
     return std::make_pair(m_optargs.cbegin(), m_optargs.cend());
 }
+std::pair<std::vector<OptionDefinition>::const_iterator,
+          std::vector<OptionDefinition>::const_iterator>
+Command::get_option_iter() const
+{
+    return std::make_pair(m_options.cbegin(), m_options.cend());
+}
+
+// shared by the ostream and context overloads of Command::format_usage_into,
+// the names owned by the command are referenced instead of copied
+template<typename Stream>
+static void __format_usage(
+        Stream& stream,
+        const std::vector<ArgumentDefinition>& args,
+        const std::vector<ArgumentDefinition>& optargs,
+        const std::vector<OptionDefinition>& options,
+        const std::string& alias,
+        const std::string& command_prefix,
+        const std::string& arg_before,
+        const std::string& arg_before_type,
+        const std::string& arg_after_type,
+        const std::string& arg_after,
+        const std::string& optarg_before,
+        const std::string& optarg_after)
+{
+    stream << command_prefix << alias << ' ';
+
+    if(!args.empty())
+    {
+        for(auto arg_it = args.cbegin(); arg_it != args.cend(); arg_it++)
+        {
+            const char* type_name = arg_it->get_type_name();
+            
+            stream << arg_before << nnwcli::ref(arg_it->m_name) << arg_before_type << nnwcli::ref(type_name) << arg_after_type << arg_after;
+            if(arg_it + 1 != args.cend())
+                stream << ' ';
+        }
+    }
+    if(!optargs.empty())
+    {
+        for(auto optarg_it = optargs.cbegin(); optarg_it != optargs.cend(); optarg_it++)
+        {
+            const char* type_name = optarg_it->get_type_name();
+
+            stream << optarg_before << nnwcli::ref(optarg_it->m_name) << arg_before_type << nnwcli::ref(type_name) << arg_after_type << optarg_after;
+            if(optarg_it + 1 != optargs.cend())
+                stream << ' ';
+        }
+    }
+    // [-v|--verbose] [--port=<+int>]
+    for(auto option_it = options.cbegin(); option_it != options.cend(); option_it++)
+    {
+        const OptionDefinition& option = *option_it;
+
+        if(option_it != options.cbegin() || !args.empty() || !optargs.empty())
+            stream << ' ';
+        stream << optarg_before;
+        if(option.m_short)
+            stream << '-' << option.m_short << '|';
+        stream << "--" << nnwcli::ref(option.m_name);
+        if(!option.is_flag())
+            stream << "=<" << option.get_type_name() << '>';
+        stream << optarg_after;
+    }
+}
 
 void Command::format_usage_into(
         std::ostream& stream,
@@ -91,28 +204,23 @@ void Command::format_usage_into(
         const std::string description_after
         ) const
 {
-    stream << command_prefix << alias << " ";
-
-    if(!m_args.empty())
-    {
-        for(auto arg_it = m_args.cbegin(); arg_it != m_args.cend(); arg_it++)
-        {
-            const char* type_name = argtype_to_name(arg_it->m_type);
-            
-            stream << arg_before << arg_it->m_name << arg_before_type << type_name << arg_after_type << arg_after;
-            if(arg_it + 1 != m_args.cend())
-                stream << " ";
-        }
-    }
-    if(!m_optargs.empty())
-    {
-        for(auto optarg_it = m_optargs.cbegin(); optarg_it != m_optargs.cend(); optarg_it++)
-        {
-            const char* type_name = argtype_to_name(optarg_it->m_type);
-
-            stream << optarg_before << optarg_it->m_name << arg_before_type << type_name << arg_after_type << optarg_after;
-            if(optarg_it + 1 != m_optargs.cend())
-                stream << " ";
-        }
-    }
+    __format_usage(stream, m_args, m_optargs, m_options, alias, command_prefix, arg_before, arg_before_type,
+            arg_after_type, arg_after, optarg_before, optarg_after);
+}
+void Command::format_usage_into(
+        CommandExecutorContext& context,
+        const std::string alias,
+        const std::string command_prefix,
+        const std::string arg_before,
+        const std::string arg_before_type,
+        const std::string arg_after_type,
+        const std::string arg_after,
+        const std::string optarg_before,
+        const std::string optarg_after,
+        const std::string description_before,
+        const std::string description_after
+        ) const
+{
+    __format_usage(context, m_args, m_optargs, m_options, alias, command_prefix, arg_before, arg_before_type,
+            arg_after_type, arg_after, optarg_before, optarg_after);
 }
@@ -9,8 +9,15 @@
 
 
 #include "command_executor.hpp"
+#include "journal.hpp"
+#include "inflight.hpp"
 #include "parser/argline_parser.hpp"
+#include "parser/binary_parser.hpp"
+#include "util/string_case.hpp"
+#include "watch.hpp"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iterator>
 #include <memory>
 #include <mutex>
@@ -20,14 +27,32 @@
 using namespace nnwcli;
 
 
+void CommandStatistics::add(
+        const DispatchResult result, const std::chrono::nanoseconds time, const AllocationCounters& counters)
+{
+    m_dispatches++;
+    if(result != DR_SUCCESS)
+        m_failures++;
+    m_total_time += time;
+    m_max_time = std::max(m_max_time, time);
+    m_allocations += counters.m_allocations;
+    m_allocated_bytes += counters.m_allocated_bytes;
+    m_max_allocated_bytes = std::max(m_max_allocated_bytes, counters.m_allocated_bytes);
+    m_peak_bytes = std::max(m_peak_bytes, counters.m_peak_bytes);
+}
+
+
 CommandExecutor::CommandExecutor() :
-    m_context_factory(nullptr), m_latest_context(nullptr) {}
+    m_case_insensitive(false), m_context_factory(nullptr), m_latest_context(nullptr),
+    m_encoding_policy(EP_PASS_THROUGH), m_next_context_id(0) {}
 CommandExecutor::CommandExecutor(
         const std::function<std::shared_ptr<CommandExecutorContext>()>& context_factory) :
-    m_context_factory(context_factory), m_latest_context(nullptr) {}
+    m_case_insensitive(false), m_context_factory(context_factory), m_latest_context(nullptr),
+    m_encoding_policy(EP_PASS_THROUGH), m_next_context_id(0) {}
 CommandExecutor::CommandExecutor(
         const std::function<std::shared_ptr<CommandExecutorContext>()>&& context_factory) :
-    m_context_factory(context_factory), m_latest_context(nullptr) {}
+    m_case_insensitive(false), m_context_factory(context_factory), m_latest_context(nullptr),
+    m_encoding_policy(EP_PASS_THROUGH), m_next_context_id(0) {}
 
 const std::function<std::shared_ptr<CommandExecutorContext>()>&
 CommandExecutor::get_factory()
@@ -42,16 +67,118 @@ CommandExecutor::set_factory(
     m_context_factory = factory;
 }
 
+void CommandExecutor::set_journal(std::shared_ptr<CommandJournal> journal)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_journal = journal;
+}
+std::shared_ptr<CommandJournal> CommandExecutor::get_journal() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_journal;
+}
+void CommandExecutor::set_encoding_policy(const EncodingPolicy policy)
+{
+    m_encoding_policy = policy;
+}
+EncodingPolicy CommandExecutor::get_encoding_policy() const
+{
+    return m_encoding_policy;
+}
+void CommandExecutor::set_case_insensitive(const bool case_insensitive)
+{
+    m_case_insensitive = case_insensitive;
+}
+bool CommandExecutor::is_case_insensitive() const
+{
+    return m_case_insensitive;
+}
+std::string CommandExecutor::_lookup_name(const std::string& name) const
+{
+    std::string lookup_name = name;
+    if(m_case_insensitive)
+        fold_case(lookup_name);
+    return lookup_name;
+}
+std::map<std::string, std::shared_ptr<Command>>::iterator CommandExecutor::_find_alias(const std::string& lookup_name)
+{
+    if(!m_case_insensitive)
+        return m_aliases.find(lookup_name);
+
+    auto folded = m_folded_aliases.find(lookup_name);
+    if(folded == m_folded_aliases.end())
+        return m_aliases.end();
+    return m_aliases.find(folded->second);
+}
+void CommandExecutor::_rebuild_folded_aliases()
+{
+    std::string folded;
+
+    m_folded_aliases.clear();
+    for(const auto& alias : m_aliases)
+    {
+        folded = alias.first;
+        fold_case(folded);
+        m_folded_aliases.emplace(folded, alias.first);
+    }
+}
+
+std::vector<InflightDispatch> CommandExecutor::get_inflight() const
+{
+    return m_inflight.snapshot();
+}
+std::pmr::memory_resource* CommandExecutor::get_memory_resource()
+{
+    return counting_memory_resource();
+}
+CommandStatistics CommandExecutor::get_statistics(const std::string name)
+{
+    const std::shared_ptr<Command>& cmd = get_command(name);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto found = m_statistics.find(cmd->get_name());
+
+    if(found == m_statistics.cend())
+        return CommandStatistics();
+    return found->second;
+}
+CommandStatistics CommandExecutor::get_total_statistics() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_total_statistics;
+}
+std::map<std::string, CommandStatistics> CommandExecutor::get_all_statistics() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+void CommandExecutor::reset_statistics()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_statistics.clear();
+    m_total_statistics = CommandStatistics();
+}
+
+TypeRegistry& CommandExecutor::get_type_registry()
+{
+    return m_type_registry;
+}
+
 bool CommandExecutor::register_command(
         const std::string name, const std::shared_ptr<Command> command)
 {
     auto cmd = m_aliases.find(name);
+    std::string folded = name;
 
     if(cmd != m_aliases.cend())
         return false;
+    fold_case(folded);
+    if(m_case_insensitive && m_folded_aliases.count(folded))
+        return false;
 
+    command->resolve_argument_types(m_type_registry);
     m_commands.insert(command);
     m_aliases[name] = command;
+    m_folded_aliases.emplace(std::move(folded), name);
 
     return true;
 }
@@ -61,11 +188,18 @@ bool CommandExecutor::register_command(std::shared_ptr<Command> command)
 }
 bool CommandExecutor::add_alias(const std::string target, const std::string src)
 {
+    std::string folded = target;
+
     if(m_aliases.find(target) != m_aliases.cend())
         return false;
+    fold_case(folded);
+    if(m_case_insensitive && m_folded_aliases.count(folded))
+        return false;
 
     try {
         auto res = m_aliases.insert({target, m_aliases.at(src)});
+        if(res.second)
+            m_folded_aliases.emplace(std::move(folded), target);
         return res.second;
     } catch (const std::out_of_range& e) {
         return false;
@@ -78,6 +212,7 @@ bool CommandExecutor::remove_alias(const std::string cmd)
         return false;
 
     m_aliases.erase(found);
+    _rebuild_folded_aliases();
     return true;
 }
 bool CommandExecutor::unregister_command(
@@ -88,7 +223,8 @@ bool CommandExecutor::unregister_command(
     if(found == m_aliases.end())
         return false;
 
-    auto& cmd = found->second;
+    // a copy, the alias it comes from is erased below
+    const std::shared_ptr<Command> cmd = found->second;
     m_commands.erase(cmd);
 
     if(delete_aliases)
@@ -102,6 +238,7 @@ bool CommandExecutor::unregister_command(
             else
                 it++;
         }
+        _rebuild_folded_aliases();
     }
     return true;
 }
@@ -110,170 +247,387 @@ bool CommandExecutor::dispatch_line(
         std::shared_ptr<CommandExecutorContext> context_override,
         void* const data)
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
+    const DispatchResult result = dispatch_line_detailed(line, context_override, data);
+
+    return result != DR_UNKNOWN_COMMAND && result != DR_SYNTAX_ERROR;
+}
+DispatchResult CommandExecutor::dispatch_line_detailed(
+        const std::string& line,
+        std::shared_ptr<CommandExecutorContext> context_override,
+        void* const data)
+{
+    // the repaired line is dispatched and journaled instead, the rejected one is reported by _dispatch
+    const std::string* dispatched = &line;
+    std::string replaced;
+    if(m_encoding_policy == EP_REPLACE && !utf8_validate(line))
+    {
+        replaced = line;
+        utf8_replace_invalid(replaced);
+        dispatched = &replaced;
+    }
+
     // get the command name
-    const std::size_t _spl = line.find_first_of(__whitespace);
+    std::size_t _spl;
     std::string cmdname;
     std::string argline;
 
-    if(_spl != std::string::npos)
+    if(m_case_insensitive)
     {
-        cmdname = line.substr(0, _spl);
-        argline = line.substr(_spl + 1);
+        // folded in the same pass that finds its end
+        _spl = fold_case_until(dispatched->data(), dispatched->size(), __whitespace, cmdname);
     }
     else
     {
-        cmdname = line;
+        _spl = std::min(dispatched->find_first_of(__whitespace), dispatched->size());
+        cmdname = dispatched->substr(0, _spl);
     }
+    if(_spl < dispatched->size())
+        argline = dispatched->substr(_spl + 1);
+    return _dispatch(cmdname, nullptr, true, argline, nullptr, std::move(context_override), data, dispatched);
+}
+CommandHandle CommandExecutor::resolve(const std::string& name)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto found = _find_alias(_lookup_name(name));
 
-    // create the argline parser
-    auto parser = std::static_pointer_cast<AbstractParser>(
-            std::make_shared<ArglineParser>(argline));
-    if(context_override)
-        m_latest_context = context_override;
-    else
-        m_latest_context = m_context_factory();
-    auto ctx = m_latest_context.get();
-    m_latest_context->set_parser(parser);
-    m_latest_context->set_executor(this);
-    auto cmd = m_aliases.find(cmdname);
+    if(found == m_aliases.cend())
+        return CommandHandle();
+    return CommandHandle{found->second, name};
+}
+DispatchResult CommandExecutor::dispatch_binary(
+        const CommandHandle& command,
+        const std::string_view data,
+        std::shared_ptr<CommandExecutorContext> context)
+{
+    return _dispatch(command.m_alias, command.m_command, false, std::string(),
+            std::make_shared<BinaryParser>(data), std::move(context), nullptr, nullptr);
+}
+DispatchResult CommandExecutor::dispatch_binary(
+        const std::string& name,
+        const std::string_view data,
+        std::shared_ptr<CommandExecutorContext> context)
+{
+    return _dispatch(_lookup_name(name), nullptr, true, std::string(),
+            std::make_shared<BinaryParser>(data), std::move(context), nullptr, nullptr);
+}
+DispatchResult CommandExecutor::_dispatch(
+        const std::string& cmdname,
+        std::shared_ptr<Command> cmd,
+        const bool lookup,
+        const std::string& argline,
+        std::shared_ptr<AbstractParser> parser,
+        std::shared_ptr<CommandExecutorContext> context_override,
+        void* const data,
+        const std::string* const line)
+{
+    std::shared_ptr<CommandExecutorContext> ctx;
+    DispatchResult result;
+    const auto started = std::chrono::system_clock::now();
+    const auto started_steady = std::chrono::steady_clock::now();
+    AllocationCounters counters;
+    const EncodingPolicy encoding_policy = m_encoding_policy;
 
-    if(cmd == m_aliases.cend())
     {
-        // command not found
-        handle_unknown_command(cmdname, m_latest_context);
-        return false;
+        // the context and the parser are accounted as well
+        AllocationScope scope;
+
+        // the executor is locked only to resolve the command, not to execute it
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if(context_override)
+                m_latest_context = context_override;
+            else
+                m_latest_context = m_context_factory();
+            ctx = m_latest_context;
+            if(!ctx->get_id())
+                ctx->set_id(++m_next_context_id);
+
+            if(lookup)
+            {
+                auto found = _find_alias(cmdname);
+                if(found != m_aliases.cend())
+                    cmd = found->second;
+            }
+        }
+
+        // create the argline parser
+        if(!parser)
+        {
+            std::pmr::memory_resource* const resource = get_memory_resource();
+            auto argline_parser = std::allocate_shared<ArglineParser>(
+                    std::pmr::polymorphic_allocator<ArglineParser>(resource), argline, 0, resource);
+            argline_parser->set_encoding_policy(encoding_policy);
+            parser = std::static_pointer_cast<AbstractParser>(std::move(argline_parser));
+        }
+        parser->set_type_registry(&m_type_registry);
+        ctx->set_parser(parser);
+        ctx->set_executor(this);
+
+        ctx->begin_dispatch();
+        try
+        {
+            if(line && encoding_policy == EP_REJECT && !utf8_validate(*line))
+            {
+                // not counted as a dispatch of the command
+                cmd = nullptr;
+                handle_invalid_encoding(*line, ctx);
+                result = DR_SYNTAX_ERROR;
+            }
+            else if(!cmd)
+            {
+                // command not found
+                handle_unknown_command(cmdname, ctx);
+                result = DR_UNKNOWN_COMMAND;
+            }
+            else
+            {
+                InflightTable::Slot* const slot = m_inflight.acquire(cmd->get_name(), cmdname, argline, ctx->get_id());
+                ctx->set_output_counter(slot ? &slot->m_output_bytes : nullptr);
+                try
+                {
+                    if(cmd->is_concurrent())
+                    {
+                        result = _execute(cmd, cmdname, argline, ctx, data);
+                    }
+                    else
+                    {
+                        std::unique_lock<std::recursive_mutex> execute_lock(m_execute_mutex);
+                        result = _execute(cmd, cmdname, argline, ctx, data);
+                    }
+                }
+                catch(...)
+                {
+                    ctx->set_output_counter(nullptr);
+                    m_inflight.release(slot);
+                    throw;
+                }
+                ctx->set_output_counter(nullptr);
+                m_inflight.release(slot);
+            }
+        }
+        catch(...)
+        {
+            ctx->end_dispatch();
+            throw;
+        }
+        ctx->end_dispatch();
+        counters = scope.get_counters();
     }
+    const auto elapsed = std::chrono::steady_clock::now() - started_steady;
+    std::shared_ptr<CommandJournal> journal;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_total_statistics.add(result, elapsed, counters);
+        if(cmd)
+            m_statistics[cmd->get_name()].add(result, elapsed, counters);
+        journal = m_journal;
+    }
+
+    if(journal && line)
+    {
+        try
+        {
+            journal->append(*line, ctx->get_id(), result, started, std::chrono::system_clock::now());
+        }
+        catch(const journal_io_error& e)
+        {
+            // the command has run already, only the journal is given up, unless it was replaced meanwhile
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(m_journal == journal)
+                m_journal = nullptr;
+        }
+    }
+    return result;
+}
+DispatchResult CommandExecutor::_execute(
+        const std::shared_ptr<Command>& cmd,
+        const std::string& cmdname,
+        const std::string& argline,
+        const std::shared_ptr<CommandExecutorContext>& context,
+        void* const data)
+{
+    CommandExecutorContext* const ctx = context.get();
+    const std::shared_ptr<AbstractParser> parser = ctx->get_parser();
+    std::shared_ptr<Command> command = cmd;
 
     // dispatch the command
     try
     {
-        m_latest_context->set_command(cmdname, cmd->second);
+        ctx->set_command(cmdname, command);
+        parser->set_options(&cmd->get_option_index());
 
-        cmd->second->execute(m_latest_context.get(), data);
+        if(!cmd->execute(ctx, data))
+            return DR_FAILURE;
     }
     // parser errors
     catch(const unexpected_escape_character& e)
     {
-        *m_latest_context << "Error: unexpected escape character encountered at the end of the line.\n";
-        m_latest_context->flush();
-        return false;
+        *ctx << "Error: unexpected escape character encountered at the end of the line.\n";
+        ctx->flush();
+        return DR_SYNTAX_ERROR;
+    }
+    catch(const binary_format_error& e)
+    {
+        *ctx << "Error: binary arguments are truncated or malformed.\n";
+        ctx->flush();
+        return DR_SYNTAX_ERROR;
     }
     catch(const invalid_escape_format& e)
     {
-        std::stringstream ss;
-        std::string argname;
-        const char* argtype;
         std::pair<
             std::vector<ArgumentDefinition>::const_iterator,
             std::vector<ArgumentDefinition>::const_iterator
             > it;
-        if(parser->get_argument_pos() + 1 > cmd->second->get_args_count())
+        if(parser->get_argument_pos() + 1 > cmd->get_args_count())
         {
-            it = cmd->second->get_optarg_iter();
-            std::advance(it.first, parser->get_argument_pos() - cmd->second->get_args_count());
+            it = cmd->get_optarg_iter();
+            std::advance(it.first, parser->get_argument_pos() - cmd->get_args_count());
         }
         else
         {
-            it = cmd->second->get_arg_iter();
+            it = cmd->get_arg_iter();
             std::advance(it.first, parser->get_argument_pos());
         }
-        ss << "Invalid escape code sequence specified for argument \"" << it.first->m_name << "\":" << std::endl;
-        ss << argline.substr(parser->get_pos()) << std::endl;
-        *ctx << ss;
+        *ctx << "Invalid escape code sequence specified for argument \"" << it.first->m_name << "\":\n";
+        // the position is in the line the parser keeps, without the option tokens
+        const auto* const argline_parser = dynamic_cast<const ArglineParser*>(parser.get());
+        const std::string_view parsed = argline_parser ? argline_parser->get_argline() : std::string_view(argline);
+        *ctx << parsed.substr(std::min(parser->get_pos(), parsed.size())) << '\n';
         ctx->flush();
+        return DR_ARGUMENT_ERROR;
 
     }
     catch(const std::out_of_range& e)
     {
-        std::stringstream ss;
-        std::string argname;
-        const char* argtype;
         std::pair<
             std::vector<ArgumentDefinition>::const_iterator,
             std::vector<ArgumentDefinition>::const_iterator
             > it;
-        if(parser->get_argument_pos() + 1 > cmd->second->get_args_count())
+        if(parser->get_argument_pos() + 1 > cmd->get_args_count())
         {
             // report optional argument instead
-            it = cmd->second->get_optarg_iter();
-            std::advance(it.first, parser->get_argument_pos() - cmd->second->get_args_count());
+            it = cmd->get_optarg_iter();
+            std::advance(it.first, parser->get_argument_pos() - cmd->get_args_count());
         }
         else
         {
             // report mandatory argument
-            it = cmd->second->get_arg_iter();
+            it = cmd->get_arg_iter();
             std::advance(it.first, parser->get_argument_pos());
         }
-        ss << "Value outside of the boundaries provided for argument \"" << it.first->m_name << "\"." << std::endl;
-        *ctx << ss;
+        *ctx << "Value outside of the boundaries provided for argument \"" << it.first->m_name << "\".\n";
         ctx->flush();
+        return DR_ARGUMENT_ERROR;
 
     }
     catch(const std::invalid_argument& e)
     {
-        std::stringstream ss;
-        std::string argname;
-        const char* argtype;
         std::pair<
             std::vector<ArgumentDefinition>::const_iterator,
             std::vector<ArgumentDefinition>::const_iterator
             > it;
-        if(parser->get_argument_pos() + 1 > cmd->second->get_args_count())
+        if(parser->get_argument_pos() + 1 > cmd->get_args_count())
         {
-            it = cmd->second->get_optarg_iter();
-            std::advance(it.first, parser->get_argument_pos() - cmd->second->get_args_count());
+            it = cmd->get_optarg_iter();
+            std::advance(it.first, parser->get_argument_pos() - cmd->get_args_count());
         }
         else
         {
-            it = cmd->second->get_arg_iter();
+            it = cmd->get_arg_iter();
             std::advance(it.first, parser->get_argument_pos());
         }
         if(!it.first.base())
         {
             throw std::runtime_error("invalid iterator");
         }
-        ss << "Invalid value specified for argument \"" << it.first->m_name << "\"." << std::endl;
+        *ctx << "Invalid value specified for argument \"" << it.first->m_name << "\".\n";
 
-        cmd->second->format_usage_into(ss, ctx->get_alias());
-        ss << std::endl;
+        cmd->format_usage_into(*ctx, ctx->get_alias());
+        *ctx << '\n';
 
-        *ctx << ss;
         ctx->flush();
+        return DR_ARGUMENT_ERROR;
     }
     catch(const too_many_arguments& e)
     {
-        std::stringstream ss;
-        ss << "This command requires at most " << cmd->second->get_args_count() + cmd->second->get_optargs_count() << 
-            " arguments, but received more." << std::endl;
-        cmd->second->format_usage_into(ss, cmdname);
-        ss << std::endl;
-        *ctx << ss;
+        *ctx << "This command requires at most " << cmd->get_args_count() + cmd->get_optargs_count() << 
+            " arguments, but received more.\n";
+        cmd->format_usage_into(*ctx, cmdname);
+        *ctx << '\n';
+        ctx->flush();
+        return DR_ARGUMENT_ERROR;
+    }
+    catch(const unknown_option& e)
+    {
+        *ctx << "Unknown option \"--" << e.m_name << "\".\n";
+        cmd->format_usage_into(*ctx, ctx->get_alias());
+        *ctx << '\n';
+        ctx->flush();
+        return DR_ARGUMENT_ERROR;
+    }
+    catch(const invalid_option_value& e)
+    {
+        if(e.m_out_of_range)
+            *ctx << "Value outside of the boundaries provided for option \"" << e.m_name << "\".\n";
+        else
+            *ctx << "Invalid value specified for option \"" << e.m_name << "\".\n";
+        cmd->format_usage_into(*ctx, ctx->get_alias());
+        *ctx << '\n';
+        ctx->flush();
+        return DR_ARGUMENT_ERROR;
+    }
+    catch(const unknown_argument& e)
+    {
+        *ctx << "Error: the command has no argument \"" << e.m_name << "\".\n";
+        ctx->flush();
+        return DR_FAILURE;
+    }
+    catch(const unknown_custom_type& e)
+    {
+        *ctx << "Error: argument type of the command is not registered.\n";
         ctx->flush();
+        return DR_ARGUMENT_ERROR;
     }
     catch(const not_enough_arguments& e)
     {
-        std::stringstream ss;
-        ss << "This command requires at least " << cmd->second->get_args_count() << " arguments, but received "
-            << ctx->get_parser()->get_argument_pos() << "." << std::endl;
-        cmd->second->format_usage_into(ss, ctx->get_alias());
-        ss << std::endl;
-        *ctx << ss;
+        *ctx << "This command requires at least " << cmd->get_args_count() << " arguments, but received "
+            << ctx->get_parser()->get_argument_pos() << ".\n";
+        cmd->format_usage_into(*ctx, ctx->get_alias());
+        *ctx << '\n';
         ctx->flush();
+        return DR_ARGUMENT_ERROR;
     }
-    return true;
+    return DR_SUCCESS;
 }
 
+std::shared_ptr<CommandWatch> CommandExecutor::watch(const std::string& line,
+        std::shared_ptr<CommandExecutorContext> context, const std::chrono::milliseconds interval,
+        const WatchDiffMode mode)
+{
+    auto result = std::make_shared<CommandWatch>(*this, line, std::move(context), interval, mode);
+
+    result->start();
+    return result;
+}
 void CommandExecutor::handle_unknown_command(
         const std::string cmd, std::shared_ptr<CommandExecutorContext> context)
 {
     *context << "Unknown command: " << cmd << "\n";
     context->flush();
 }
+void CommandExecutor::handle_invalid_encoding(
+        const std::string& line, std::shared_ptr<CommandExecutorContext> context)
+{
+    *context << "Error: the line is not valid UTF-8 at octet " << utf8_find_invalid(line.data(), line.size()) << ".\n";
+    context->flush();
+}
 
 std::shared_ptr<Command>& CommandExecutor::get_command(const std::string name)
 {
-    auto cmd = m_aliases.find(name);
+    auto cmd = _find_alias(_lookup_name(name));
 
     if(cmd == m_aliases.cend())
     {
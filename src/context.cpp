@@ -7,12 +7,29 @@
 
 
 #include "context.hpp"
+#include "command.hpp"
 #include "parser/argline_parser.hpp"
+#include <charconv>
 #include <cstdarg>
 #include <memory>
 
 using namespace nnwcli;
 
+// converts the value with std::to_chars into the output of the context, or into a stack buffer
+template<std::size_t N, typename T>
+static void __write_number(CommandExecutorContext& ctx, const T value)
+{
+    char* const out = ctx.output_reserve(N);
+
+    if(out)
+    {
+        ctx.output_commit(std::to_chars(out, out + N, value).ptr - out);
+        return;
+    }
+    char buffer[N];
+    ctx.write(buffer, std::to_chars(buffer, buffer + N, value).ptr - buffer);
+}
+
 // do not initialize anything, set executor and parser later
 CommandExecutorContext::CommandExecutorContext(
         CommandExecutor* const executor, const std::string argline)
@@ -74,7 +91,66 @@ void CommandExecutorContext::set_command(std::string alias, std::shared_ptr<Comm
 {
     m_alias = alias;
     m_command = command;
+    m_arguments.reset(m_parser ? m_parser->get_pos() : 0);
+}
+const ArgumentDefinition& CommandExecutorContext::_find_argument(
+        const std::string_view name, std::size_t& index, bool& required) const
+{
+    const Command* const command = get_command();
+
+    if(command)
+    {
+        const auto args = command->get_arg_iter();
+        for(auto it = args.first; it != args.second; it++)
+        {
+            if(it->m_name == name)
+            {
+                index = it - args.first;
+                required = true;
+                return *it;
+            }
+        }
+        const auto optargs = command->get_optarg_iter();
+        for(auto it = optargs.first; it != optargs.second; it++)
+        {
+            if(it->m_name == name)
+            {
+                index = command->get_args_count() + (it - optargs.first);
+                required = false;
+                return *it;
+            }
+        }
+    }
+    throw unknown_argument(std::string(name));
+}
+std::uint64_t CommandExecutorContext::get_id() const
+{
+    return m_id;
 }
+void CommandExecutorContext::set_id(const std::uint64_t id)
+{
+    m_id = id;
+}
+void CommandExecutorContext::set_output_counter(std::atomic<std::uint64_t>* const counter)
+{
+    m_output_counter = counter;
+}
+void CommandExecutorContext::count_output(const std::size_t n)
+{
+    if(m_output_counter)
+        m_output_counter->fetch_add(n, std::memory_order_relaxed);
+}
+void CommandExecutorContext::write_ref(const char* const data, const std::size_t n)
+{
+    write(data, n);
+}
+char* CommandExecutorContext::output_reserve(std::size_t)
+{
+    return nullptr;
+}
+void CommandExecutorContext::output_commit(std::size_t) {}
+void CommandExecutorContext::begin_dispatch() {}
+void CommandExecutorContext::end_dispatch() {}
 void CommandExecutorContext::nprintf(const char* format, std::size_t n, ...)
 {
     va_list args;
@@ -91,9 +167,9 @@ void CommandExecutorContext::nprintf(const std::string& format, std::size_t n, .
     vnprintf(format, n, args);
     va_end(args);
 }
-CommandExecutorContext& CommandExecutorContext::operator<<(const char* data)
+CommandExecutorContext& CommandExecutorContext::operator<<(const char* const data)
 {
-    write(data);
+    write(data, std::strlen(data));
     return *this;
 }
 CommandExecutorContext& CommandExecutorContext::operator<<(const std::string& data)
@@ -106,3 +182,154 @@ CommandExecutorContext& CommandExecutorContext::operator<<(const std::stringstre
     write(data.str());
     return *this;
 }
+CommandExecutorContext& CommandExecutorContext::operator<<(const OutputRef& data)
+{
+    write_ref(data.m_data, data.m_size);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const std::string_view data)
+{
+    write(data.data(), data.size());
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const char value)
+{
+    write(&value, 1);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const bool value)
+{
+    if(value)
+        write("true", 4);
+    else
+        write("false", 5);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const signed char value)
+{
+    __write_number<8>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const unsigned char value)
+{
+    __write_number<8>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const short value)
+{
+    __write_number<8>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const unsigned short value)
+{
+    __write_number<8>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const int value)
+{
+    __write_number<16>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const unsigned int value)
+{
+    __write_number<16>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const long value)
+{
+    __write_number<24>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const unsigned long value)
+{
+    __write_number<24>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const long long value)
+{
+    __write_number<24>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const unsigned long long value)
+{
+    __write_number<24>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const float value)
+{
+    __write_number<32>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const double value)
+{
+    __write_number<32>(*this, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::operator<<(const long double value)
+{
+    __write_number<64>(*this, value);
+    return *this;
+}
+StreamResult CommandExecutorContext::stream(OutputCursor& cursor, const std::size_t max_rows)
+{
+    StreamResult result{0, false};
+
+    while(!max_rows || result.m_rows < max_rows)
+    {
+        if(cursor.at_end())
+            break;
+        cursor.next(*this);
+        if(++result.m_rows % stream_flush_rows == 0)
+            flush();
+    }
+    result.m_exhausted = cursor.at_end();
+    return result;
+}
+StreamResult CommandExecutorContext::stream_page(
+        OutputCursor& cursor, const std::size_t page, const std::size_t page_rows)
+{
+    if(page > 1)
+        cursor.skip((page - 1) * page_rows);
+    return stream(cursor, page_rows);
+}
+const std::shared_ptr<RecordSerializer>& CommandExecutorContext::get_serializer()
+{
+    if(!m_serializer)
+        m_serializer = std::make_shared<TextRecordSerializer>();
+    return m_serializer;
+}
+void CommandExecutorContext::set_serializer(std::shared_ptr<RecordSerializer> serializer)
+{
+    m_serializer = std::move(serializer);
+    m_in_record = false;
+}
+void CommandExecutorContext::set_record_format(const RecordFormat format)
+{
+    set_serializer(make_record_serializer(format));
+}
+CommandExecutorContext& CommandExecutorContext::begin_record(const std::string_view name)
+{
+    if(m_in_record)
+    {
+        m_in_record = false;
+        throw record_error();
+    }
+    get_serializer()->begin_record(*this, name);
+    m_in_record = true;
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::write_field(const std::string_view key, const RecordValue& value)
+{
+    if(!m_in_record)
+        throw record_error();
+    m_serializer->field(*this, key, value);
+    return *this;
+}
+CommandExecutorContext& CommandExecutorContext::end_record()
+{
+    if(!m_in_record)
+        throw record_error();
+    m_in_record = false;
+    m_serializer->end_record(*this);
+    return *this;
+}
@@ -0,0 +1,34 @@
+/**
+ * cursor.cpp - Streaming output of large command results.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "cursor.hpp"
+#include "context.hpp"
+
+using namespace nnwcli;
+
+
+// used to skip the rows of the cursors that can't seek
+class __DiscardContext : public CommandExecutorContext
+{
+public:
+    virtual void write(const char*, std::size_t) override {}
+    virtual void write(const std::string&) override {}
+    virtual void vnprintf(const char*, std::size_t, va_list) override {}
+    virtual void vnprintf(const std::string&, std::size_t, va_list) override {}
+    virtual void flush() override {}
+};
+
+std::size_t OutputCursor::skip(const std::size_t rows)
+{
+    __DiscardContext discard;
+    std::size_t skipped = 0;
+
+    for(; skipped < rows && !at_end(); skipped++)
+        next(discard);
+    return skipped;
+}
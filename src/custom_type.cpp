@@ -0,0 +1,104 @@
+/**
+ * custom_type.cpp - Argument types defined by the application, in addition to "argument_types.hpp".
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "custom_type.hpp"
+
+using namespace nnwcli;
+
+// exceptions
+
+const char* bad_custom_value::what() const noexcept
+{
+    return "custom value holds another type";
+}
+
+
+CustomValue::CustomValue() noexcept :
+    m_heap(nullptr), m_operations(nullptr), m_type(0) {}
+CustomValue::CustomValue(const CustomValue& other) :
+    CustomValue()
+{
+    *this = other;
+}
+CustomValue::CustomValue(CustomValue&& other) noexcept :
+    CustomValue()
+{
+    _take(other);
+}
+CustomValue& CustomValue::operator=(const CustomValue& other)
+{
+    if(this == &other)
+        return *this;
+
+    if(other.m_operations)
+        other.m_operations->m_copy(*this, other._value());
+    else
+        reset();
+    m_type = other.m_type;
+    return *this;
+}
+CustomValue& CustomValue::operator=(CustomValue&& other) noexcept
+{
+    if(this != &other)
+    {
+        reset();
+        _take(other);
+    }
+    return *this;
+}
+CustomValue::~CustomValue()
+{
+    reset();
+}
+void CustomValue::_take(CustomValue& other) noexcept
+{
+    if(other.m_operations)
+    {
+        if(other.m_operations->m_inline)
+            other.m_operations->m_move(m_storage, other.m_storage);
+        else
+            m_heap = other.m_heap;
+    }
+    m_operations = other.m_operations;
+    m_type = other.m_type;
+    other.m_heap = nullptr;
+    other.m_operations = nullptr;
+    other.m_type = 0;
+}
+void* CustomValue::_value()
+{
+    return m_operations && m_operations->m_inline ? m_storage : m_heap;
+}
+const void* CustomValue::_value() const
+{
+    return m_operations && m_operations->m_inline ? m_storage : m_heap;
+}
+void CustomValue::reset()
+{
+    if(m_operations)
+        m_operations->m_destroy(_value());
+    m_heap = nullptr;
+    m_operations = nullptr;
+    m_type = 0;
+}
+bool CustomValue::empty() const
+{
+    return !m_operations;
+}
+bool CustomValue::is_inline() const
+{
+    return m_operations && m_operations->m_inline;
+}
+CustomTypeId CustomValue::get_type() const
+{
+    return m_type;
+}
+void CustomValue::set_type(const CustomTypeId type)
+{
+    m_type = type;
+}
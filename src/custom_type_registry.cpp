@@ -0,0 +1,49 @@
+/**
+ * custom_type_registry.cpp - Registry of the custom argument types, owned by CommandExecutor.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "custom_type_registry.hpp"
+#include "parser/abstract_parser.hpp"
+
+using namespace nnwcli;
+
+
+CustomTypeId TypeRegistry::register_custom_type(const std::string& name, std::shared_ptr<AbstractCustomType> type)
+{
+    const CustomTypeId id = static_cast<CustomTypeId>(m_types.size() + 1);
+
+    if(!m_ids.emplace(name, id).second)
+        return 0;
+    m_types.push_back(std::move(type));
+    return id;
+}
+bool TypeRegistry::unregister_custom_type(const std::string& name)
+{
+    auto found = m_ids.find(name);
+
+    if(found == m_ids.end())
+        return false;
+    m_types[found->second - 1] = nullptr;
+    m_ids.erase(found);
+    return true;
+}
+CustomTypeId TypeRegistry::find(const std::string& name) const
+{
+    auto found = m_ids.find(name);
+
+    return found == m_ids.cend() ? 0 : found->second;
+}
+const AbstractCustomType& TypeRegistry::get(const CustomTypeId id) const
+{
+    if(!id || id > m_types.size() || !m_types[id - 1])
+        throw unknown_custom_type();
+    return *m_types[id - 1];
+}
+std::size_t TypeRegistry::get_count() const
+{
+    return m_ids.size();
+}
@@ -0,0 +1,105 @@
+/**
+ * fd_context.cpp - BufferedContext writing into a POSIX file descriptor.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "fd_context.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace nnwcli;
+
+#ifdef IOV_MAX
+static constexpr std::size_t __iov_batch = std::min<std::size_t>(IOV_MAX, BufferedContext::max_fragments);
+#else
+static constexpr std::size_t __iov_batch = 16;
+#endif
+
+// exceptions
+
+const char* output_error::what() const noexcept
+{
+    return "output could not be written into the file descriptor";
+}
+
+
+FileDescriptorContext::FileDescriptorContext(
+        const int fd, const OutputMode mode, const std::size_t high_water) :
+    BufferedContext(high_water), m_fd(fd)
+{
+    m_output_mode = mode;
+}
+
+void FileDescriptorContext::sink(const char* data, std::size_t n)
+{
+    while(n)
+    {
+        const ssize_t written = ::write(m_fd, data, n);
+
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            throw output_error(errno);
+        }
+        data += written;
+        n -= written;
+    }
+}
+void FileDescriptorContext::sinkv(const OutputFragment* const fragments, const std::size_t count)
+{
+    struct iovec iov[__iov_batch];
+    std::size_t i = 0;
+
+    while(i < count)
+    {
+        const std::size_t batch = std::min(count - i, __iov_batch);
+        for(std::size_t j = 0; j < batch; j++)
+        {
+            iov[j].iov_base = const_cast<char*>(fragments[i + j].m_data);
+            iov[j].iov_len = fragments[i + j].m_size;
+        }
+
+        // retry until the whole batch is written, skipping the fragments written so far
+        struct iovec* pending = iov;
+        std::size_t left = batch;
+        while(left)
+        {
+            ssize_t written = ::writev(m_fd, pending, left);
+
+            if(written < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+                throw output_error(errno);
+            }
+            while(left && static_cast<std::size_t>(written) >= pending->iov_len)
+            {
+                written -= pending->iov_len;
+                pending++;
+                left--;
+            }
+            if(left)
+            {
+                pending->iov_base = static_cast<char*>(pending->iov_base) + written;
+                pending->iov_len -= written;
+            }
+        }
+        i += batch;
+    }
+}
+int FileDescriptorContext::get_fd() const
+{
+    return m_fd;
+}
+
+#endif
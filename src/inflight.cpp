@@ -0,0 +1,107 @@
+/**
+ * inflight.cpp - Lock-free table of the dispatches that are being executed right now.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "inflight.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+using namespace nnwcli;
+
+
+static unsigned char __copy_truncated(char* const out, const std::size_t size, const std::string& in)
+{
+    const std::size_t n = std::min(size, in.size());
+
+    std::memcpy(out, in.data(), n);
+    return n;
+}
+
+InflightTable::Slot::Slot() :
+    m_busy(false), m_sequence(0), m_context_id(0),
+    m_command_size(0), m_alias_size(0), m_argline_size(0), m_output_bytes(0) {}
+
+InflightTable::InflightTable() : m_untracked(0) {}
+
+InflightTable::Slot* InflightTable::acquire(
+        const std::string& command, const std::string& alias,
+        const std::string& argline, const std::uint64_t context_id)
+{
+    // threads start looking from different slots to avoid contending for the first ones
+    const std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % slot_count;
+
+    for(std::size_t i = 0; i < slot_count; i++)
+    {
+        Slot& slot = m_slots[(start + i) % slot_count];
+        bool expected = false;
+
+        if(slot.m_busy.load(std::memory_order_relaxed) ||
+                !slot.m_busy.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            continue;
+
+        slot.m_sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.m_thread = std::this_thread::get_id();
+        slot.m_context_id = context_id;
+        slot.m_started = std::chrono::steady_clock::now();
+        slot.m_command_size = __copy_truncated(slot.m_command, name_size, command);
+        slot.m_alias_size = __copy_truncated(slot.m_alias, name_size, alias);
+        slot.m_argline_size = __copy_truncated(slot.m_argline, argline_size, argline);
+        slot.m_output_bytes.store(0, std::memory_order_relaxed);
+        slot.m_sequence.fetch_add(1, std::memory_order_release);
+        return &slot;
+    }
+    m_untracked.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+void InflightTable::release(Slot* const slot)
+{
+    if(!slot)
+        return;
+    // readers that copied the slot before it got free will see the sequence change
+    slot->m_sequence.fetch_add(1, std::memory_order_relaxed);
+    slot->m_busy.store(false, std::memory_order_release);
+    slot->m_sequence.fetch_add(1, std::memory_order_release);
+}
+std::vector<InflightDispatch> InflightTable::snapshot() const
+{
+    std::vector<InflightDispatch> result;
+    const auto now = std::chrono::steady_clock::now();
+
+    for(const Slot& slot : m_slots)
+    {
+        const std::uint32_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+
+        if((sequence & 1) || !slot.m_busy.load(std::memory_order_acquire))
+            continue;
+
+        InflightDispatch entry;
+        entry.m_thread = slot.m_thread;
+        entry.m_context_id = slot.m_context_id;
+        entry.m_started = slot.m_started;
+        entry.m_command.assign(slot.m_command, std::min<std::size_t>(slot.m_command_size, name_size));
+        entry.m_alias.assign(slot.m_alias, std::min<std::size_t>(slot.m_alias_size, name_size));
+        entry.m_argline.assign(slot.m_argline, std::min<std::size_t>(slot.m_argline_size, argline_size));
+        entry.m_output_bytes = slot.m_output_bytes.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.m_sequence.load(std::memory_order_relaxed) != sequence)
+            // the slot was released or reused while being copied
+            continue;
+
+        entry.m_elapsed = now - entry.m_started;
+        result.push_back(std::move(entry));
+    }
+    std::sort(result.begin(), result.end(),
+            [](const InflightDispatch& a, const InflightDispatch& b) { return a.m_started < b.m_started; });
+    return result;
+}
+std::size_t InflightTable::get_untracked_count() const
+{
+    return m_untracked.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,351 @@
+/**
+ * journal.cpp - Recording and replaying of the dispatched command lines.
+ * Records are serialized into a string buffer under a mutex, and the buffer is written to the file
+ * with a single fwrite once it grows past the batch size. The file itself is unbuffered,
+ * so that the batching is not doubled by stdio.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "journal.hpp"
+#include "util/varint.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace nnwcli;
+
+static const char __journal_magic[4] = {'N', 'N', 'W', 'J'};
+static const char __journal_version = 1;
+
+// exceptions
+
+const char* journal_io_error::what() const noexcept
+{
+    return "journal file could not be opened, read or written";
+}
+const char* journal_format_error::what() const noexcept
+{
+    return "journal file is malformed";
+}
+
+
+CommandJournal::CommandJournal(const std::string& path, const std::size_t batch_size) :
+    m_batch_size(batch_size), m_opened(std::chrono::system_clock::now())
+{
+    m_file = std::fopen(path.c_str(), "wb");
+    if(!m_file)
+        throw journal_io_error();
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+    m_buffer.reserve(m_batch_size + 256);
+    m_buffer.append(__journal_magic, sizeof(__journal_magic));
+    m_buffer.push_back(__journal_version);
+    varint_write(m_buffer, std::chrono::duration_cast<std::chrono::microseconds>(
+                m_opened.time_since_epoch()).count());
+    try
+    {
+        _write_batch();
+    }
+    catch(const journal_io_error& e)
+    {
+        std::fclose(m_file);
+        throw;
+    }
+}
+CommandJournal::~CommandJournal()
+{
+    // a destructor can't report the error, close() can
+    try
+    {
+        close();
+    }
+    catch(const journal_io_error& e) {}
+}
+void CommandJournal::_write_batch()
+{
+    if(m_buffer.empty())
+        return;
+    if(!m_file || std::fwrite(m_buffer.data(), sizeof(char), m_buffer.size(), m_file) != m_buffer.size())
+    {
+        m_buffer.clear();
+        throw journal_io_error();
+    }
+    m_buffer.clear();
+}
+void CommandJournal::append(
+        const std::string& line, const std::uint64_t context_id, const DispatchResult result,
+        const std::chrono::system_clock::time_point started,
+        const std::chrono::system_clock::time_point finished)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // threads are numbered in order of appearance
+    const auto thread = m_threads.emplace(std::this_thread::get_id(), m_threads.size()).first->second;
+
+    varint_write_signed(m_buffer, duration_cast<microseconds>(started - m_opened).count());
+    varint_write(m_buffer, std::max<std::int64_t>(0, duration_cast<microseconds>(finished - started).count()));
+    varint_write(m_buffer, thread);
+    varint_write(m_buffer, context_id);
+    m_buffer.push_back(static_cast<char>(result));
+    varint_write(m_buffer, line.size());
+    m_buffer.append(line);
+
+    if(m_buffer.size() >= m_batch_size)
+        _write_batch();
+}
+void CommandJournal::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    _write_batch();
+}
+void CommandJournal::close()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if(!m_file)
+        return;
+    try
+    {
+        _write_batch();
+    }
+    catch(const journal_io_error& e)
+    {
+        std::fclose(m_file);
+        m_file = nullptr;
+        throw;
+    }
+    const bool closed = std::fclose(m_file) == 0;
+    m_file = nullptr;
+    if(!closed)
+        throw journal_io_error();
+}
+std::size_t CommandJournal::get_batch_size() const
+{
+    return m_batch_size;
+}
+void CommandJournal::set_batch_size(const std::size_t batch_size)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_batch_size = batch_size;
+}
+
+
+JournalReader::JournalReader(const std::string& path) : m_pos(0)
+{
+    m_file = std::fopen(path.c_str(), "rb");
+    if(!m_file)
+        throw journal_io_error();
+
+    if(!_fill(sizeof(__journal_magic) + 1) ||
+            std::memcmp(m_buffer.data(), __journal_magic, sizeof(__journal_magic)) != 0 ||
+            m_buffer[sizeof(__journal_magic)] != __journal_version)
+    {
+        std::fclose(m_file);
+        throw journal_format_error();
+    }
+    m_pos = sizeof(__journal_magic) + 1;
+    try
+    {
+        m_opened = std::chrono::system_clock::time_point(std::chrono::microseconds(_read_varint()));
+    }
+    catch(const journal_format_error& e)
+    {
+        std::fclose(m_file);
+        throw;
+    }
+}
+JournalReader::~JournalReader()
+{
+    std::fclose(m_file);
+}
+bool JournalReader::_fill(const std::size_t n)
+{
+    if(m_buffer.size() - m_pos >= n)
+        return true;
+
+    // drop the consumed part, then read in large blocks
+    m_buffer.erase(0, m_pos);
+    m_pos = 0;
+    char block[65536];
+    while(m_buffer.size() < n)
+    {
+        const std::size_t read = std::fread(block, sizeof(char), sizeof(block), m_file);
+        if(!read)
+            return false;
+        m_buffer.append(block, read);
+    }
+    return true;
+}
+std::uint64_t JournalReader::_read_varint()
+{
+    std::uint64_t value;
+
+    // a varint takes at most 10 octets, but the file may end earlier
+    _fill(10);
+    const std::size_t read = varint_read(m_buffer.data() + m_pos, m_buffer.size() - m_pos, value);
+    if(!read)
+        throw journal_format_error();
+    m_pos += read;
+    return value;
+}
+bool JournalReader::read(JournalRecord& out)
+{
+    if(!_fill(1))
+        return false;
+
+    std::int64_t offset;
+    _fill(10);
+    const std::size_t read = varint_read_signed(m_buffer.data() + m_pos, m_buffer.size() - m_pos, offset);
+    if(!read)
+        throw journal_format_error();
+    m_pos += read;
+
+    out.m_offset = offset;
+    out.m_duration = _read_varint();
+    out.m_thread = _read_varint();
+    out.m_context_id = _read_varint();
+    if(!_fill(1))
+        throw journal_format_error();
+    out.m_result = static_cast<DispatchResult>(m_buffer[m_pos++]);
+
+    const std::uint64_t size = _read_varint();
+    if(!_fill(size))
+        throw journal_format_error();
+    out.m_line.assign(m_buffer, m_pos, size);
+    m_pos += size;
+    return true;
+}
+std::chrono::system_clock::time_point JournalReader::get_open_time() const
+{
+    return m_opened;
+}
+
+
+// detaches the journal of the executor for its lifetime, and attaches it back unless another one was set meanwhile
+class __JournalDetach
+{
+    CommandExecutor&                m_executor;
+    std::shared_ptr<CommandJournal> m_journal;
+public:
+    __JournalDetach(CommandExecutor& executor) : m_executor(executor), m_journal(executor.get_journal())
+    {
+        if(m_journal)
+            m_executor.set_journal(nullptr);
+    }
+    ~__JournalDetach()
+    {
+        if(m_journal && !m_executor.get_journal())
+            m_executor.set_journal(m_journal);
+    }
+};
+
+JournalReplayer::JournalReplayer(CommandExecutor& executor, const double speed) :
+    m_executor(executor), m_speed(speed), m_context_factory(nullptr) {}
+
+void JournalReplayer::set_speed(const double speed)
+{
+    m_speed = speed;
+}
+double JournalReplayer::get_speed() const
+{
+    return m_speed;
+}
+void JournalReplayer::set_context_factory(
+        const std::function<std::shared_ptr<CommandExecutorContext>(std::uint64_t)>& factory)
+{
+    m_context_factory = factory;
+}
+ReplayReport JournalReplayer::replay(const std::string& path)
+{
+    JournalReader reader(path);
+    std::vector<JournalRecord> records;
+    JournalRecord record;
+
+    while(reader.read(record))
+        records.push_back(std::move(record));
+    return replay(records);
+}
+ReplayReport JournalReplayer::replay(const std::vector<JournalRecord>& records)
+{
+    ReplayReport report;
+    report.m_records = records.size();
+    if(records.empty())
+        return report;
+
+    // record indexes, grouped by the thread that dispatched them, in the order of dispatch
+    std::map<std::uint64_t, std::vector<std::size_t>> threads;
+    std::int64_t first_offset = records.front().m_offset;
+    for(std::size_t i = 0; i < records.size(); i++)
+    {
+        threads[records[i].m_thread].push_back(i);
+        first_offset = std::min(first_offset, records[i].m_offset);
+    }
+    for(auto& thread : threads)
+    {
+        std::stable_sort(thread.second.begin(), thread.second.end(),
+                [&records](const std::size_t a, const std::size_t b)
+                { return records[a].m_offset < records[b].m_offset; });
+    }
+
+    std::mutex mutex;
+    std::map<std::uint64_t, std::shared_ptr<CommandExecutorContext>> contexts;
+    // the replayed lines would be recorded again, into the journal they may come from
+    __JournalDetach detach(m_executor);
+    const auto started = std::chrono::steady_clock::now();
+
+    auto worker = [&](const std::vector<std::size_t>& indexes)
+    {
+        for(const std::size_t i : indexes)
+        {
+            const JournalRecord& rec = records[i];
+            std::shared_ptr<CommandExecutorContext> context;
+
+            if(m_speed > 0)
+            {
+                const std::chrono::duration<double, std::micro> delay((rec.m_offset - first_offset) / m_speed);
+                std::this_thread::sleep_until(
+                        started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+            }
+            try
+            {
+                if(m_context_factory)
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    auto found = contexts.find(rec.m_context_id);
+                    if(found == contexts.end())
+                        found = contexts.emplace(rec.m_context_id, m_context_factory(rec.m_context_id)).first;
+                    context = found->second;
+                }
+
+                const DispatchResult result = m_executor.dispatch_line_detailed(rec.m_line, context);
+                if(result != rec.m_result)
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    report.m_mismatches.push_back(i);
+                }
+            }
+            catch(...)
+            {
+                // an exception would terminate the worker thread, the rest of its lines are replayed anyway
+                std::unique_lock<std::mutex> lock(mutex);
+                report.m_errors.push_back(i);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads.size());
+    for(const auto& thread : threads)
+        workers.emplace_back(worker, std::cref(thread.second));
+    for(auto& thread : workers)
+        thread.join();
+
+    report.m_elapsed = std::chrono::steady_clock::now() - started;
+    std::sort(report.m_mismatches.begin(), report.m_mismatches.end());
+    std::sort(report.m_errors.begin(), report.m_errors.end());
+    return report;
+}
@@ -0,0 +1,311 @@
+/**
+ * list.cpp - Decoding of the CT_LIST arguments straight into std::vector.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "list.hpp"
+#include "util/string_case.hpp"
+#include <bitset>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNWCLI_LIST_SSE2
+#endif
+
+using namespace nnwcli;
+
+
+static std::string_view __trim(std::string_view text)
+{
+    while(!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        text.remove_prefix(1);
+    while(!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        text.remove_suffix(1);
+    return text;
+}
+// the elements, without the brackets
+static std::string_view __body(std::string_view text)
+{
+    text = __trim(text);
+    if(!text.empty() && text.front() == '[')
+    {
+        if(text.back() != ']' || text.size() < 2)
+            throw std::invalid_argument("list is missing the closing bracket");
+        text = __trim(text.substr(1, text.size() - 2));
+    }
+    return text;
+}
+template<typename Callback>
+static void __split(const std::string_view body, Callback element)
+{
+    std::size_t start = 0;
+
+    if(body.empty())
+        return;
+    while(true)
+    {
+        const std::size_t comma = body.find(',', start);
+        const std::string_view value = __trim(body.substr(start, comma - start));
+
+        if(value.empty())
+            throw std::invalid_argument("list has an empty element");
+        element(value);
+        if(comma == std::string_view::npos)
+            break;
+        start = comma + 1;
+    }
+}
+
+/**
+ * Whether the body consists only of digits, commas and, for the signed types, minus signs.
+ * Counts the commas on the way, so that the vector is allocated once.
+ * */
+static bool __scan_integers(const std::string_view body, const bool allow_minus, std::size_t& commas)
+{
+    const char* const data = body.data();
+    const std::size_t n = body.size();
+    std::size_t i = 0;
+
+    commas = 0;
+#ifdef NNWCLI_LIST_SSE2
+    const __m128i below_digits = _mm_set1_epi8('0' - 1);
+    const __m128i above_digits = _mm_set1_epi8('9' + 1);
+    const __m128i comma = _mm_set1_epi8(',');
+    // without the minus sign, commas are compared twice instead
+    const __m128i minus = _mm_set1_epi8(allow_minus ? '-' : ',');
+
+    for(; i + 16 <= n; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // octets above 0x7F are negative, so the signed comparisons reject them
+        const __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(chunk, below_digits), _mm_cmplt_epi8(chunk, above_digits));
+        const __m128i commas_found = _mm_cmpeq_epi8(chunk, comma);
+        const __m128i valid = _mm_or_si128(_mm_or_si128(digits, commas_found), _mm_cmpeq_epi8(chunk, minus));
+
+        if(_mm_movemask_epi8(valid) != 0xFFFF)
+            return false;
+        commas += std::bitset<16>(_mm_movemask_epi8(commas_found)).count();
+    }
+#endif
+    for(; i < n; i++)
+    {
+        const char c = data[i];
+
+        if(c == ',')
+            commas++;
+        else if((c < '0' || c > '9') && (!allow_minus || c != '-'))
+            return false;
+    }
+    return true;
+}
+// converts 8 digits at once, false when some of them are not digits
+static bool __eight_digits(const char* const in, std::uint64_t& value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::uint64_t octets;
+
+    std::memcpy(&octets, in, sizeof(octets));
+    // every high nibble is 3 and no low nibble is above 9
+    if(((octets & 0xF0F0F0F0F0F0F0F0) | (((octets + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) !=
+            0x3333333333333333)
+        return false;
+    octets -= 0x3030303030303030;
+    octets = octets * 10 + (octets >> 8);
+    value = (((octets & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+            (((octets >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+    return true;
+#else
+    return false;
+#endif
+}
+template<typename T>
+static T __narrow(const std::uint64_t magnitude, const bool negative)
+{
+    if constexpr(std::is_signed_v<T>)
+    {
+        const std::uint64_t max = static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+
+        if(negative)
+        {
+            if(magnitude > max + 1)
+                throw std::out_of_range("list element is out of range");
+            return magnitude ? static_cast<T>(-static_cast<std::int64_t>(magnitude - 1) - 1) : 0;
+        }
+        if(magnitude > max)
+            throw std::out_of_range("list element is out of range");
+    }
+    else if(magnitude > std::numeric_limits<T>::max())
+        throw std::out_of_range("list element is out of range");
+    return static_cast<T>(magnitude);
+}
+template<typename T>
+static void __decode_integers_fast(const std::string_view body, const std::size_t commas, std::vector<T>& out)
+{
+    const char* in = body.data();
+    const char* const end = in + body.size();
+
+    out.reserve(commas + 1);
+    while(true)
+    {
+        const bool negative = std::is_signed_v<T> && *in == '-';
+        std::uint64_t magnitude = 0;
+        std::uint64_t eight;
+        // the rest of the element is still checked, malformed elements are reported as such
+        bool overflow = false;
+
+        if(negative)
+            in++;
+
+        const char* const start = in;
+        while(end - in >= 8 && __eight_digits(in, eight))
+        {
+            if(magnitude > (std::numeric_limits<std::uint64_t>::max() - eight) / 100000000)
+                overflow = true;
+            magnitude = magnitude * 100000000 + eight;
+            in += 8;
+        }
+        while(in != end && *in >= '0' && *in <= '9')
+        {
+            const unsigned int digit = *in - '0';
+
+            if(magnitude > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+                overflow = true;
+            magnitude = magnitude * 10 + digit;
+            in++;
+        }
+        // no digits, or a minus sign in the middle of a number
+        if(in == start || (in != end && *in != ','))
+            throw std::invalid_argument("list element is not a number");
+        if(overflow)
+            throw std::out_of_range("list element is out of range");
+        out.push_back(__narrow<T>(magnitude, negative));
+
+        if(in == end)
+            break;
+        if(++in == end)
+            throw std::invalid_argument("list has an empty element");
+    }
+}
+template<typename T>
+static void __decode_integers(const std::string_view text, std::vector<T>& out)
+{
+    const std::string_view body = __body(text);
+    std::size_t commas;
+
+    out.clear();
+    if(body.empty())
+        return;
+    if(__scan_integers(body, std::is_signed_v<T>, commas))
+    {
+        __decode_integers_fast(body, commas, out);
+        return;
+    }
+
+    // whitespace or something that is not a number, the elements are found one by one
+    using Wide = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>;
+    __split(body, [&out](const std::string_view element)
+    {
+        Wide value;
+        const auto result = std::from_chars(element.data(), element.data() + element.size(), value);
+
+        if(result.ec == std::errc::invalid_argument || result.ptr != element.data() + element.size())
+            throw std::invalid_argument("list element is not a number");
+        if(result.ec == std::errc::result_out_of_range)
+            throw std::out_of_range("list element is out of range");
+        if(value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+            throw std::out_of_range("list element is out of range");
+        out.push_back(static_cast<T>(value));
+    });
+}
+template<typename T>
+static void __decode_floats(const std::string_view text, std::vector<T>& out)
+{
+    out.clear();
+    __split(__body(text), [&out](const std::string_view element)
+    {
+        T value;
+        const auto result = std::from_chars(element.data(), element.data() + element.size(), value);
+
+        if(result.ec == std::errc::invalid_argument || result.ptr != element.data() + element.size())
+            throw std::invalid_argument("list element is not a number");
+        if(result.ec == std::errc::result_out_of_range)
+            throw std::out_of_range("list element is out of range");
+        out.push_back(value);
+    });
+}
+
+
+void nnwcli::decode_list(const std::string_view text, std::vector<char>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<short>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<int>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<long>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<unsigned char>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<unsigned short>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<unsigned int>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<unsigned long>& out)
+{
+    __decode_integers(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<float>& out)
+{
+    __decode_floats(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<double>& out)
+{
+    __decode_floats(text, out);
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<bool>& out)
+{
+    out.clear();
+    __split(__body(text), [&out](const std::string_view element)
+    {
+        std::string word(element);
+
+        make_lowercase(word);
+        if(word == "yes" || word == "on" || word == "true" || word == "y" || word == "t" || word == "1")
+            out.push_back(true);
+        else if(word == "no" || word == "off" || word == "false" || word == "n" || word == "f" || word == "0")
+            out.push_back(false);
+        else
+            throw std::invalid_argument("bool can be either on or off, yes or no, true or false");
+    });
+}
+void nnwcli::decode_list(const std::string_view text, std::vector<std::string>& out)
+{
+    out.clear();
+    __split(__body(text), [&out](const std::string_view element)
+    {
+        out.emplace_back(element);
+    });
+}
@@ -2,7 +2,7 @@
  * main.cpp - Source file for nnwcli_example executable.
  * Intended for test purposes only, doesn't serve any other purpose than prompting
  * the stdin for input and dispatching the lines as commands.
- * Implements StdoutContext for showing command output straight into the stdout.
+ * Implements StdoutContext for showing command output in the stdout, on top of BufferedContext.
  * Also contains an example of how to implement commands, parse arguments and register commands.
  * 
  * License: The MIT License.
@@ -12,10 +12,13 @@
 
 #include "builtin/help.hpp"
 #include "builtin/helpof.hpp"
+#include "builtin/top.hpp"
 #include "argument_types.hpp"
+#include "buffered_context.hpp"
 #include "command.hpp"
 #include "command_executor.hpp"
 #include "context.hpp"
+#include "format.hpp"
 #include "parser/abstract_parser.hpp"
 #include <cstddef>
 #include <cstdio>
@@ -27,32 +30,13 @@
 #include <string>
 
 
-// Context implementation: output everything straight into the stdout.
-class StdoutContext : public nnwcli::CommandExecutorContext
+// Context implementation: output everything into the stdout, one write per command.
+class StdoutContext : public nnwcli::BufferedContext
 {
-public:
-    virtual void write(const char* data, const std::size_t n) override
+protected:
+    virtual void sink(const char* data, const std::size_t n) override
     {
         std::fwrite(data, sizeof(char), n, stdout);
-    }
-    virtual void write(const std::string& data) override
-    {
-        std::fwrite(data.c_str(), sizeof(char), data.size(), stdout);
-    }
-    virtual void vnprintf(const char* format, const std::size_t n, va_list args) override
-    {
-        char nullterm_buffer[n];
-        int size = std::vsnprintf(nullterm_buffer, n, format, args);
-        std::fwrite(nullterm_buffer, sizeof(char), size, stdout);
-    }
-    virtual void vnprintf(const std::string& format, const std::size_t n, va_list args) override
-    {
-        char nullterm_buffer[n];
-        std::vsnprintf(nullterm_buffer, n, format.c_str(), args);
-        std::fwrite(nullterm_buffer, sizeof(char), n, stdout);
-    }
-    virtual void flush() override
-    {
         std::fflush(stdout);
     }
 };
@@ -83,7 +67,7 @@ public:
         parser->parse_finish();
 
         // print the result
-        context->nprintf("Result: %d\n", 65535, arg1 + arg2);
+        nnwcli::format(context, NNWCLI_FORMAT("Result: {}\n"), arg1 + arg2);
         return true;
     }
 };
@@ -131,6 +115,7 @@ int main(int argc, char* argv[])
     executor.register_command(std::make_shared<EchoCommand>());
     executor.register_command(std::make_shared<HelpCommand>());
     executor.register_command(std::make_shared<HelpOfCommand>());
+    executor.register_command(std::make_shared<TopCommand>());
 
     if(!executor.add_alias("msg", "echo"))
     {
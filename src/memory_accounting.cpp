@@ -0,0 +1,270 @@
+/**
+ * memory_accounting.cpp - Counting of the memory allocated by the current thread.
+ * With NNWCLI_ALLOCATION_HOOK defined, this file also replaces the global operator new and delete.
+ * The replacements prefix every block with its size, so that the unsized delete can account it.
+ * The over-aligned blocks have a prefix of their alignment, which their delete is given back.
+ * They live in the same file as AllocationScope, so that linking the static library
+ * pulls them in whenever the executor is used.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "memory_accounting.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+using namespace nnwcli;
+
+static thread_local AllocationScope* __current_scope = nullptr;
+
+
+AllocationScope::AllocationScope() : m_parent(__current_scope)
+{
+    __current_scope = this;
+}
+AllocationScope::~AllocationScope()
+{
+    __current_scope = m_parent;
+    if(m_parent)
+    {
+        AllocationCounters& parent = m_parent->m_counters;
+
+        parent.m_allocations += m_counters.m_allocations;
+        parent.m_allocated_bytes += m_counters.m_allocated_bytes;
+        parent.m_peak_bytes = std::max(parent.m_peak_bytes, parent.m_live_bytes + m_counters.m_peak_bytes);
+        parent.m_live_bytes += m_counters.m_live_bytes;
+    }
+}
+const AllocationCounters& AllocationScope::get_counters() const
+{
+    return m_counters;
+}
+AllocationScope* AllocationScope::current()
+{
+    return __current_scope;
+}
+void AllocationScope::record_allocation(const std::size_t bytes)
+{
+    AllocationScope* const scope = __current_scope;
+
+    if(!scope)
+        return;
+    scope->m_counters.m_allocations++;
+    scope->m_counters.m_allocated_bytes += bytes;
+    scope->m_counters.m_live_bytes += bytes;
+    scope->m_counters.m_peak_bytes = std::max(scope->m_counters.m_peak_bytes, scope->m_counters.m_live_bytes);
+}
+void AllocationScope::record_deallocation(const std::size_t bytes)
+{
+    AllocationScope* const scope = __current_scope;
+
+    if(scope)
+        scope->m_counters.m_live_bytes -= bytes;
+}
+bool AllocationScope::is_hooked()
+{
+#ifdef NNWCLI_ALLOCATION_HOOK
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+CountingMemoryResource::CountingMemoryResource(std::pmr::memory_resource* const upstream) :
+    m_upstream(upstream) {}
+
+void* CountingMemoryResource::do_allocate(const std::size_t bytes, const std::size_t alignment)
+{
+    void* const p = m_upstream->allocate(bytes, alignment);
+#ifndef NNWCLI_ALLOCATION_HOOK
+    // with the hook, the upstream allocation is already counted by operator new
+    AllocationScope::record_allocation(bytes);
+#endif
+    return p;
+}
+void CountingMemoryResource::do_deallocate(void* const p, const std::size_t bytes, const std::size_t alignment)
+{
+    m_upstream->deallocate(p, bytes, alignment);
+#ifndef NNWCLI_ALLOCATION_HOOK
+    AllocationScope::record_deallocation(bytes);
+#endif
+}
+bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+std::pmr::memory_resource* CountingMemoryResource::get_upstream() const
+{
+    return m_upstream;
+}
+std::pmr::memory_resource* nnwcli::counting_memory_resource()
+{
+    // the contexts and the parsers may be freed by the destructors of other static objects
+    static CountingMemoryResource* const resource = new CountingMemoryResource();
+    return resource;
+}
+
+
+#ifdef NNWCLI_ALLOCATION_HOOK
+
+// keeps the returned memory aligned for any fundamental type
+static const std::size_t __hook_prefix = alignof(std::max_align_t);
+
+static void* __hooked_allocate(const std::size_t size) noexcept
+{
+    char* const block = static_cast<char*>(std::malloc(size + __hook_prefix));
+
+    if(!block)
+        return nullptr;
+    *reinterpret_cast<std::size_t*>(block) = size;
+    AllocationScope::record_allocation(size);
+    return block + __hook_prefix;
+}
+static void __hooked_free(void* const p) noexcept
+{
+    if(!p)
+        return;
+    char* const block = static_cast<char*>(p) - __hook_prefix;
+
+    AllocationScope::record_deallocation(*reinterpret_cast<std::size_t*>(block));
+    std::free(block);
+}
+static void* __hooked_allocate_or_throw(const std::size_t size)
+{
+    for(;;)
+    {
+        void* const p = __hooked_allocate(size);
+        if(p)
+            return p;
+
+        const std::new_handler handler = std::get_new_handler();
+        if(!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void* __hooked_allocate_aligned(const std::size_t size, const std::size_t alignment) noexcept
+{
+    const std::size_t prefix = std::max(alignment, __hook_prefix);
+    // aligned_alloc() wants the size to be a multiple of the alignment
+    char* const block = static_cast<char*>(std::aligned_alloc(alignment,
+                (prefix + size + alignment - 1) / alignment * alignment));
+
+    if(!block)
+        return nullptr;
+    *reinterpret_cast<std::size_t*>(block) = size;
+    AllocationScope::record_allocation(size);
+    return block + prefix;
+}
+static void __hooked_free_aligned(void* const p, const std::size_t alignment) noexcept
+{
+    if(!p)
+        return;
+    char* const block = static_cast<char*>(p) - std::max(alignment, __hook_prefix);
+
+    AllocationScope::record_deallocation(*reinterpret_cast<std::size_t*>(block));
+    std::free(block);
+}
+static void* __hooked_allocate_aligned_or_throw(const std::size_t size, const std::size_t alignment)
+{
+    for(;;)
+    {
+        void* const p = __hooked_allocate_aligned(size, alignment);
+        if(p)
+            return p;
+
+        const std::new_handler handler = std::get_new_handler();
+        if(!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(const std::size_t size)
+{
+    return __hooked_allocate_or_throw(size);
+}
+void* operator new[](const std::size_t size)
+{
+    return __hooked_allocate_or_throw(size);
+}
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return __hooked_allocate(size);
+}
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return __hooked_allocate(size);
+}
+void operator delete(void* const p) noexcept
+{
+    __hooked_free(p);
+}
+void operator delete[](void* const p) noexcept
+{
+    __hooked_free(p);
+}
+void operator delete(void* const p, std::size_t) noexcept
+{
+    __hooked_free(p);
+}
+void operator delete[](void* const p, std::size_t) noexcept
+{
+    __hooked_free(p);
+}
+void operator delete(void* const p, const std::nothrow_t&) noexcept
+{
+    __hooked_free(p);
+}
+void operator delete[](void* const p, const std::nothrow_t&) noexcept
+{
+    __hooked_free(p);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    return __hooked_allocate_aligned_or_throw(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+    return __hooked_allocate_aligned_or_throw(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return __hooked_allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return __hooked_allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* const p, const std::align_val_t alignment) noexcept
+{
+    __hooked_free_aligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* const p, const std::align_val_t alignment) noexcept
+{
+    __hooked_free_aligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* const p, std::size_t, const std::align_val_t alignment) noexcept
+{
+    __hooked_free_aligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* const p, std::size_t, const std::align_val_t alignment) noexcept
+{
+    __hooked_free_aligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* const p, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    __hooked_free_aligned(p, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* const p, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    __hooked_free_aligned(p, static_cast<std::size_t>(alignment));
+}
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * option.cpp - Options of the commands, which are given by their names anywhere in the argument line.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "option.hpp"
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+using namespace nnwcli;
+
+// exceptions
+
+const char* unknown_option::what() const noexcept
+{
+    return "option is not known to the command";
+}
+const char* invalid_option_value::what() const noexcept
+{
+    return m_out_of_range ? "option value is out of range" : "option value is invalid";
+}
+
+
+static bool __is_letter(const char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+void OptionIndex::build(const std::vector<OptionDefinition>& options, const std::size_t full_position)
+{
+    if(options.size() >= std::numeric_limits<std::uint16_t>::max())
+        throw std::invalid_argument("too many options");
+
+    std::size_t bucket_count = 4;
+    while(bucket_count < options.size() * 2)
+        bucket_count *= 2;
+
+    m_options = options;
+    m_full_position = full_position;
+    m_buckets.assign(options.empty() ? 0 : bucket_count, 0);
+    m_short.fill(0);
+    for(std::size_t i = 0; i < m_options.size(); i++)
+    {
+        const OptionDefinition& option = m_options[i];
+
+        if(find(option.m_name) != npos)
+            throw std::invalid_argument("option is declared twice");
+        std::size_t bucket = std::hash<std::string_view>()(option.m_name) & (m_buckets.size() - 1);
+        while(m_buckets[bucket])
+            bucket = (bucket + 1) & (m_buckets.size() - 1);
+        m_buckets[bucket] = static_cast<std::uint16_t>(i + 1);
+
+        if(option.m_short)
+        {
+            if(!__is_letter(option.m_short))
+                throw std::invalid_argument("short option name has to be a letter");
+            if(m_short[static_cast<unsigned char>(option.m_short)])
+                throw std::invalid_argument("option is declared twice");
+            m_short[static_cast<unsigned char>(option.m_short)] = static_cast<std::uint16_t>(i + 1);
+        }
+    }
+}
+std::size_t OptionIndex::find(const std::string_view name) const
+{
+    if(m_buckets.empty())
+        return npos;
+
+    std::size_t bucket = std::hash<std::string_view>()(name) & (m_buckets.size() - 1);
+    // the table is at most half full, so there is always an empty bucket to stop at
+    for(; m_buckets[bucket]; bucket = (bucket + 1) & (m_buckets.size() - 1))
+    {
+        if(m_options[m_buckets[bucket] - 1].m_name == name)
+            return m_buckets[bucket] - 1;
+    }
+    return npos;
+}
+std::size_t OptionIndex::find_short(const char name) const
+{
+    if(!__is_letter(name) || !m_short[static_cast<unsigned char>(name)])
+        return npos;
+    return m_short[static_cast<unsigned char>(name)] - 1;
+}
+std::size_t OptionIndex::get_count() const
+{
+    return m_options.size();
+}
+bool OptionIndex::empty() const
+{
+    return m_options.empty();
+}
+const OptionDefinition& OptionIndex::get(const std::size_t index) const
+{
+    return m_options[index];
+}
+std::size_t OptionIndex::get_full_position() const
+{
+    return m_full_position;
+}
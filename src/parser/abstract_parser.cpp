@@ -16,6 +16,9 @@
 
 
 #include "parser/abstract_parser.hpp"
+#include "blob.hpp"
+#include "custom_type_registry.hpp"
+#include <stdexcept>
 
 using namespace nnwcli;
 
@@ -33,6 +36,10 @@ const char* too_many_arguments::what() const noexcept
 {
     return "too many arguments specified";
 }
+const char* unknown_custom_type::what() const noexcept
+{
+    return "argument type is not registered";
+}
 
 
 std::size_t AbstractParser::get_pos() const
@@ -55,6 +62,136 @@ void AbstractParser::reset_argument_pos()
 {
     m_argument_pos = 0;
 }
+void AbstractParser::set_argument_pos(const std::size_t argument_pos)
+{
+    m_argument_pos = argument_pos;
+}
+const TypeRegistry* AbstractParser::get_type_registry() const
+{
+    return m_type_registry;
+}
+void AbstractParser::set_type_registry(const TypeRegistry* const registry)
+{
+    m_type_registry = registry;
+}
+void AbstractParser::set_options(const OptionIndex* const options)
+{
+    m_options = options;
+}
+const OptionIndex* AbstractParser::get_options() const
+{
+    return m_options;
+}
+std::size_t AbstractParser::_find_option(const std::string_view name) const
+{
+    const std::size_t index = m_options ? m_options->find(name) : OptionIndex::npos;
+
+    if(index == OptionIndex::npos)
+        throw unknown_option(std::string(name));
+    return index;
+}
+// the parsers without options never have them given
+std::unique_ptr<AbstractParser> AbstractParser::_option_value(std::size_t) const
+{
+    return nullptr;
+}
+bool AbstractParser::has_option(const std::string_view name) const
+{
+    return has_option(_find_option(name));
+}
+bool AbstractParser::has_option(std::size_t) const
+{
+    return false;
+}
+bool AbstractParser::_plain_argument(std::string_view&)
+{
+    return false;
+}
+bool AbstractParser::parse_pattern(std::string& out, const Pattern& pattern, const bool required)
+{
+    if(!parse_string(out, required))
+        return false;
+    if(!pattern.matches(out))
+    {
+        m_argument_pos--;
+        throw std::invalid_argument("argument does not match the pattern");
+    }
+    return true;
+}
+bool AbstractParser::parse_custom(CustomValue& out, const CustomTypeId type, const bool required)
+{
+    if(!m_type_registry)
+        throw unknown_custom_type();
+
+    const AbstractCustomType& custom_type = m_type_registry->get(type);
+    std::string text;
+    if(!parse_string(text, required))
+        return false;
+
+    try
+    {
+        custom_type.parse(text, out);
+    }
+    catch(...)
+    {
+        // the error is reported for this argument, not the next one
+        m_argument_pos--;
+        throw;
+    }
+    out.set_type(type);
+    return true;
+}
+bool AbstractParser::parse_custom(CustomValue& out, const std::string& type_name, const bool required)
+{
+    if(!m_type_registry)
+        throw unknown_custom_type();
+    return parse_custom(out, m_type_registry->find(type_name), required);
+}
+bool AbstractParser::parse_blob(std::vector<std::uint8_t>& out, const bool required)
+{
+    std::string text;
+    std::string_view view;
+    if(!_plain_argument(view))
+    {
+        if(!parse_string(text, required))
+            return false;
+        view = text;
+    }
+
+    try
+    {
+        decode_blob(view, out);
+    }
+    catch(...)
+    {
+        m_argument_pos--;
+        throw;
+    }
+    return true;
+}
+bool AbstractParser::parse_blob(std::uint8_t* const buffer, const std::size_t capacity, std::size_t& size,
+        const bool required)
+{
+    std::string text;
+    std::string_view view;
+    if(!_plain_argument(view))
+    {
+        if(!parse_string(text, required))
+            return false;
+        view = text;
+    }
+
+    try
+    {
+        size = decode_blob(view, buffer, capacity);
+    }
+    catch(...)
+    {
+        m_argument_pos--;
+        throw;
+    }
+    return true;
+}
 
 void AbstractParser::operator>>(std::string& out)
 {
@@ -110,3 +247,8 @@ void AbstractParser::parse_finish()
     if(!exhausted())
         throw too_many_arguments();
 }
+bool AbstractParser::skip(const bool required)
+{
+    std::string ignored;
+    return parse_string(ignored, required);
+}
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <stdexcept>
 #include <string>
@@ -31,7 +32,7 @@ const char* invalid_escape_format::what() const noexcept
     return "escape format specified incorrectly";
 }
 
-std::size_t ArglineParser::_find_unescaped_quote(const std::string& argline, const std::size_t start)
+std::size_t ArglineParser::_find_unescaped_quote(const std::string_view argline, const std::size_t start)
 {
     const char quote = argline[start];
 
@@ -58,7 +59,7 @@ std::size_t ArglineParser::_find_unescaped_quote(const std::string& argline, con
     }
     throw unclosed_quote();
 }
-std::size_t ArglineParser::_find_unescaped_whitespace(const std::string& argline, std::size_t i)
+std::size_t ArglineParser::_find_unescaped_whitespace(const std::string_view argline, std::size_t i)
 {
     for(; i < argline.size(); i++)
     {
@@ -75,25 +76,36 @@ std::size_t ArglineParser::_find_unescaped_whitespace(const std::string& argline
         throw unexpected_escape_character(i);
     return std::string::npos;
 }
-void ArglineParser::_unescape_into(std::string& out, const std::string& in, std::size_t i)
+void ArglineParser::_unescape_into(std::string& out, const std::string_view in, std::size_t i)
 {
     out.clear();
     out.reserve(in.size());
 
     for(; i < in.size(); i++)
     {
-        if(in[i] == __escape)
+        // the text between the escapes is copied at once
+        const std::size_t escape = in.find(__escape, i);
+        if(escape == std::string::npos)
         {
-            if(i == in.size() - 1)
-                throw unexpected_escape_character(i);
-            i += _interpret_escape_into(out, in.size() - i, &in.c_str()[i + 1]);
-        }
-        else
-        {
-            out.push_back(in[i]);
+            out.append(in, i, std::string::npos);
+            break;
         }
+        out.append(in, i, escape - i);
+        i = escape;
+
+        if(i == in.size() - 1)
+            throw unexpected_escape_character(i);
+        i += _interpret_escape_into(out, in.size() - i, &in[i + 1]);
     }
 }
+void ArglineParser::_check_encoding(std::string& out, const std::string_view escaped) const
+{
+    // without escapes the value is a part of the line, which is checked by the executor
+    if(m_encoding_policy == EP_PASS_THROUGH || escaped.find(__escape) == std::string::npos)
+        return;
+    if(!utf8_apply_policy(out, m_encoding_policy))
+        throw std::invalid_argument("escapes produce invalid UTF-8");
+}
 std::size_t ArglineParser::_interpret_escape_into(std::string& out, std::size_t n, const char* seq)
 {
     if(!n)
@@ -160,19 +172,37 @@ std::size_t ArglineParser::_interpret_escape_into(std::string& out, std::size_t
         case 'u':
         {
             // this will create an unicode escape sequence and push it into the output.
-            if(n < 5)
+            if(n < 6)
                 throw invalid_escape_format();
 
+            // the escapes are UTF-16 units, a high surrogate takes the low one from the next \u escape
+            char16_t units[2];
+            std::size_t count = 1, consumed = 5;
             std::string raw_value(&seq[1], 4);
             make_lowercase(raw_value);
+            units[0] = std::stoul(raw_value, nullptr, 16);
+            if(units[0] >= 0xD800 && units[0] <= 0xDBFF && n >= 12 && seq[5] == __escape && seq[6] == 'u')
+            {
+                raw_value.assign(&seq[7], 4);
+                make_lowercase(raw_value);
+                units[1] = std::stoul(raw_value, nullptr, 16);
+                count = 2;
+                consumed = 11;
+            }
 
-            char octal_buffer[4] = {};
-            const unsigned long value = std::stoul(raw_value, nullptr, 16);
-
-            const std::size_t n_written = utf8_write_octets(octal_buffer, value);
+            std::string encoded;
+            try
+            {
+                utf16_to_utf8(std::u16string_view(units, count), encoded);
+            }
+            catch(const std::invalid_argument& exc)
+            {
+                // unpaired surrogate
+                throw invalid_escape_format();
+            }
             // add the unicode sequence into the output.
-            out.append(octal_buffer, n_written);
-            return 5;
+            out += encoded;
+            return consumed;
         }
         default:
         {
@@ -234,9 +264,10 @@ void ArglineParser::_next()
 
 ArglineParser::ArglineParser(
         const std::string argline,
-        const std::size_t pos)
+        const std::size_t pos,
+        std::pmr::memory_resource* const resource) :
+    m_argline(argline, resource)
 {
-    m_argline = argline;
     m_pos = pos;
 }
 
@@ -244,6 +275,119 @@ bool ArglineParser::exhausted() const
 {
     return m_pos == std::string::npos || m_pos >= m_argline.size();
 }
+std::size_t ArglineParser::_find_token_end(const std::size_t start) const
+{
+    if(m_argline[start] == __single_quote || m_argline[start] == __double_quote)
+        return _find_unescaped_quote(m_argline, start) + 1;
+
+    const std::size_t end = _find_unescaped_whitespace(m_argline, start);
+    return end == std::string::npos ? m_argline.size() : end;
+}
+void ArglineParser::_index_options()
+{
+    // the positional tokens are moved over the option tokens, together with the whitespace before them
+    std::size_t read = m_pos, write = m_pos;
+    // the positional tokens seen so far, the options stop at the one that begins the CT_FULL argument
+    std::size_t positional = 0;
+    const std::size_t full_position = m_options->get_full_position();
+
+    m_option_slots.assign(m_options->get_count(), _OptionSlot());
+    while(read < m_argline.size())
+    {
+        const std::size_t start = m_argline.find_first_not_of(__whitespace, read);
+        if(start == std::string::npos)
+            break;
+
+        std::size_t end;
+        if(m_argline.compare(start, 2, "--") == 0)
+        {
+            const std::size_t name_end = std::min(m_argline.find_first_of("= ", start + 2), m_argline.size());
+
+            if(name_end == start + 2 && (name_end == m_argline.size() || m_argline[name_end] == __whitespace))
+            {
+                // a lone -- ends the options
+                read = name_end;
+                break;
+            }
+
+            const std::string_view name = std::string_view(m_argline).substr(start + 2, name_end - start - 2);
+            const std::size_t index = m_options->find(name);
+            if(index == OptionIndex::npos)
+                throw unknown_option(std::string(name));
+
+            _OptionSlot& slot = m_option_slots[index];
+            slot.m_given = true;
+            if(name_end < m_argline.size() && m_argline[name_end] == '=')
+            {
+                end = name_end + 1 < m_argline.size() ? _find_token_end(name_end + 1) : name_end + 1;
+                slot.m_has_value = true;
+                slot.m_value.assign(m_argline, name_end + 1, end - name_end - 1);
+            }
+            else if(!m_options->get(index).is_flag())
+                throw invalid_option_value(std::string(name), false);
+            else
+                end = name_end;
+            read = end;
+            continue;
+        }
+        if(m_argline[start] == '-' && start + 1 < m_argline.size() &&
+                (start + 2 == m_argline.size() || m_argline[start + 2] == __whitespace))
+        {
+            const std::size_t index = m_options->find_short(m_argline[start + 1]);
+
+            if(index != OptionIndex::npos)
+            {
+                m_option_slots[index].m_given = true;
+                read = start + 2;
+                continue;
+            }
+        }
+
+        // the rest of the line is the text of the CT_FULL argument
+        if(positional == full_position)
+            break;
+        end = _find_token_end(start);
+        std::char_traits<char>::move(&m_argline[write], &m_argline[read], end - read);
+        write += end - read;
+        read = end;
+        positional++;
+    }
+    // whatever follows the options, including the trailing whitespace
+    m_argline.erase(write, read - write);
+}
+void ArglineParser::set_options(const OptionIndex* const options)
+{
+    AbstractParser::set_options(options);
+    m_option_slots.clear();
+    if(options && !options->empty())
+        _index_options();
+}
+bool ArglineParser::has_option(const std::size_t index) const
+{
+    return index < m_option_slots.size() && m_option_slots[index].m_given;
+}
+std::unique_ptr<AbstractParser> ArglineParser::_option_value(const std::size_t index) const
+{
+    if(index >= m_option_slots.size() || !m_option_slots[index].m_has_value)
+        return nullptr;
+
+    auto value = std::make_unique<ArglineParser>(m_option_slots[index].m_value, 0, m_argline.get_allocator().resource());
+    value->set_type_registry(m_type_registry);
+    value->set_encoding_policy(m_encoding_policy);
+    return value;
+}
+bool ArglineParser::skip(const bool required)
+{
+    _next();
+    if(required)
+        _throw_if_exhausted();
+    else if(exhausted())
+        return false;
+
+    m_pos = _find_token_end(m_pos);
+    m_argument_pos++;
+    return true;
+}
 bool ArglineParser::parse_string(std::string& out, const bool required)
 {
     std::size_t end;
@@ -258,8 +402,9 @@ bool ArglineParser::parse_string(std::string& out, const bool required)
     {
         end = _find_unescaped_quote(m_argline, m_pos);
         m_pos++;
-        const std::string escaped = m_argline.substr(m_pos, end - m_pos);
+        const std::string_view escaped = std::string_view(m_argline).substr(m_pos, end - m_pos);
         _unescape_into(out, escaped);
+        _check_encoding(out, escaped);
         m_pos = end + 1;
         m_argument_pos++;
         return true;
@@ -271,8 +416,9 @@ bool ArglineParser::parse_string(std::string& out, const bool required)
             end = m_argline.size();
     }
 
-    const std::string escaped = m_argline.substr(m_pos, end - m_pos);
+    const std::string_view escaped = std::string_view(m_argline).substr(m_pos, end - m_pos);
     _unescape_into(out, escaped);
+    _check_encoding(out, escaped);
 
     m_pos = end;
     m_argument_pos++;
@@ -289,7 +435,7 @@ bool ArglineParser::parse_bool(bool& out, const bool required)
         return false;
 
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
-    std::string arg = m_argline.substr(m_pos, end - m_pos);
+    std::string arg = std::string(m_argline, m_pos, end - m_pos);
     make_lowercase(arg);
     if(arg == "yes" || arg == "on" || arg == "true" || arg == "y" || arg == "t" || arg == "1")
     {
@@ -320,7 +466,7 @@ bool ArglineParser::parse_bigint(long& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stol(m_argline.substr(m_pos, end - m_pos));
+    out = std::stol(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -338,7 +484,7 @@ bool ArglineParser::parse_double(double& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stod(m_argline.substr(m_pos, end - m_pos));
+    out = std::stod(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -356,7 +502,7 @@ bool ArglineParser::parse_float(float& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stof(m_argline.substr(m_pos, end - m_pos));
+    out = std::stof(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -374,7 +520,7 @@ bool ArglineParser::parse_integer(int& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stoi(m_argline.substr(m_pos, end - m_pos));
+    out = std::stoi(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -392,7 +538,7 @@ bool ArglineParser::parse_shortint(short& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stoi(m_argline.substr(m_pos, end - m_pos));
+    out = std::stoi(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -410,7 +556,7 @@ bool ArglineParser::parse_tinyint(char& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stoi(m_argline.substr(m_pos, end - m_pos));
+    out = std::stoi(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -423,12 +569,58 @@ bool ArglineParser::parse_full(std::string& out, const bool required)
     else if(exhausted())
         return false;
 
-    const std::string escaped = m_argline.substr(m_pos, m_argline.size() - m_pos);
+    const std::string_view escaped = std::string_view(m_argline).substr(m_pos);
     _unescape_into(out, escaped);
+    _check_encoding(out, escaped);
     
     m_argument_pos++;
     return true;
 }
+bool ArglineParser::parse_pattern(std::string& out, const Pattern& pattern, const bool required)
+{
+    _next();
+    if(required)
+        _throw_if_exhausted();
+    else if(exhausted())
+        return false;
+
+    if(m_argline[m_pos] == __single_quote || m_argline[m_pos] == __double_quote)
+        return AbstractParser::parse_pattern(out, pattern, required);
+
+    std::uint32_t state = pattern.get_start();
+    std::size_t end = m_pos;
+    for(; end < m_argline.size() && m_argline[end] != __whitespace; end++)
+    {
+        // escapes change the value, it has to be unescaped first
+        if(m_argline[end] == __escape)
+            return AbstractParser::parse_pattern(out, pattern, required);
+        state = pattern.step(state, static_cast<unsigned char>(m_argline[end]));
+    }
+    if(!pattern.accepts(state))
+        throw std::invalid_argument("argument does not match the pattern");
+
+    out.assign(m_argline, m_pos, end - m_pos);
+    m_pos = end;
+    m_argument_pos++;
+    return true;
+}
+bool ArglineParser::_plain_argument(std::string_view& out)
+{
+    _next();
+    if(exhausted() || m_argline[m_pos] == __single_quote || m_argline[m_pos] == __double_quote)
+        return false;
+
+    const std::size_t end = std::min(m_argline.find(__whitespace, m_pos), m_argline.size());
+    const std::string_view token = std::string_view(m_argline).substr(m_pos, end - m_pos);
+    // escapes change the value, it has to be unescaped first
+    if(token.find(__escape) != std::string_view::npos)
+        return false;
+
+    out = token;
+    m_pos = end;
+    m_argument_pos++;
+    return true;
+}
 template<typename T>
 bool ArglineParser::parse_unsigned(T& out, const bool required)
 {
@@ -443,7 +635,7 @@ bool ArglineParser::parse_unsigned(T& out, const bool required)
     end = std::min(m_argline.find_first_of(' ', m_pos), m_argline.size());
 
     // attempt to convert
-    out = std::stoul(m_argline.substr(m_pos, end - m_pos));
+    out = std::stoul(std::string(m_argline, m_pos, end - m_pos));
     m_pos = end;
     m_argument_pos++;
     return true;
@@ -465,7 +657,15 @@ bool ArglineParser::parse_unsigned_tinyint(unsigned char& out, const bool requir
     return parse_unsigned<unsigned char>(out, required);
 }
 
-const std::string& ArglineParser::get_argline() const
+std::string_view ArglineParser::get_argline() const
 {
     return m_argline;
 }
+void ArglineParser::set_encoding_policy(const EncodingPolicy policy)
+{
+    m_encoding_policy = policy;
+}
+EncodingPolicy ArglineParser::get_encoding_policy() const
+{
+    return m_encoding_policy;
+}
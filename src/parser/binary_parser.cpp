@@ -0,0 +1,404 @@
+/**
+ * parser/binary_parser.cpp - Parser of typed argument lists in a compact binary form, for machine clients.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "parser/binary_parser.hpp"
+#include "util/varint.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+using namespace nnwcli;
+
+// exceptions
+
+const char* binary_format_error::what() const noexcept
+{
+    return "binary arguments are truncated or malformed";
+}
+
+
+static bool __is_signed(const ArgumentTypes type)
+{
+    return type >= ArgumentTypes::CT_TINYINT && type <= ArgumentTypes::CT_BIGINT;
+}
+static bool __is_unsigned(const ArgumentTypes type)
+{
+    return type >= ArgumentTypes::CT_UTINYINT && type <= ArgumentTypes::CT_UBIGINT;
+}
+static void __write_le(std::string& out, std::uint64_t bits, const int n)
+{
+    for(int i = 0; i < n; i++, bits >>= 8)
+        out.push_back(static_cast<char>(bits & 0xFF));
+}
+static std::uint64_t __read_le(const char* const in, const int n)
+{
+    std::uint64_t bits = 0;
+
+    for(int i = n - 1; i >= 0; i--)
+        bits = (bits << 8) | static_cast<unsigned char>(in[i]);
+    return bits;
+}
+
+
+BinaryParser::BinaryParser(const char* const data, const std::size_t n) :
+    m_data(data), m_size(n) {}
+BinaryParser::BinaryParser(const std::string_view data) :
+    m_data(data.data()), m_size(data.size()) {}
+
+bool BinaryParser::exhausted() const
+{
+    return m_pos >= m_size;
+}
+void BinaryParser::_throw_if_exhausted()
+{
+    if(exhausted())
+        throw not_enough_arguments();
+}
+bool BinaryParser::_begin(const bool required)
+{
+    if(required)
+        _throw_if_exhausted();
+    return !exhausted();
+}
+ArgumentTypes BinaryParser::_peek_type() const
+{
+    return static_cast<ArgumentTypes>(static_cast<unsigned char>(m_data[m_pos]));
+}
+std::int64_t BinaryParser::_read_signed()
+{
+    std::int64_t value;
+
+    if(!__is_signed(_peek_type()))
+        throw std::invalid_argument("argument is not a signed integer");
+
+    const std::size_t read = varint_read_signed(m_data + m_pos + 1, m_size - m_pos - 1, value);
+    if(!read)
+        throw binary_format_error();
+    m_pos += 1 + read;
+    return value;
+}
+std::uint64_t BinaryParser::_read_unsigned()
+{
+    std::uint64_t value;
+
+    if(!__is_unsigned(_peek_type()))
+        throw std::invalid_argument("argument is not an unsigned integer");
+
+    const std::size_t read = varint_read(m_data + m_pos + 1, m_size - m_pos - 1, value);
+    if(!read)
+        throw binary_format_error();
+    m_pos += 1 + read;
+    return value;
+}
+double BinaryParser::_read_floating()
+{
+    const ArgumentTypes type = _peek_type();
+    const std::size_t available = m_size - m_pos - 1;
+    double value;
+
+    if(type == ArgumentTypes::CT_FLOAT)
+    {
+        if(available < 4)
+            throw binary_format_error();
+
+        const std::uint32_t bits = static_cast<std::uint32_t>(__read_le(m_data + m_pos + 1, 4));
+        float float_value;
+        std::memcpy(&float_value, &bits, sizeof(bits));
+        value = float_value;
+        m_pos += 5;
+    }
+    else if(type == ArgumentTypes::CT_DOUBLE)
+    {
+        if(available < 8)
+            throw binary_format_error();
+
+        const std::uint64_t bits = __read_le(m_data + m_pos + 1, 8);
+        std::memcpy(&value, &bits, sizeof(bits));
+        m_pos += 9;
+    }
+    else
+        throw std::invalid_argument("argument is not a floating point number");
+    return value;
+}
+std::string_view BinaryParser::_read_string(const bool full)
+{
+    const ArgumentTypes type = _peek_type();
+    std::uint64_t size;
+
+    if(type != ArgumentTypes::CT_STRING && (!full || type != ArgumentTypes::CT_FULL))
+        throw std::invalid_argument("argument is not a string");
+
+    const std::size_t read = varint_read(m_data + m_pos + 1, m_size - m_pos - 1, size);
+    if(!read || size > m_size - m_pos - 1 - read)
+        throw binary_format_error();
+
+    const std::string_view value(m_data + m_pos + 1 + read, size);
+    m_pos += 1 + read + size;
+    return value;
+}
+template<typename T>
+bool BinaryParser::_parse_signed(T& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    const std::size_t pos = m_pos;
+    const std::int64_t value = _read_signed();
+    if(value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+    {
+        m_pos = pos;
+        throw std::out_of_range("integer argument is out of range");
+    }
+    out = static_cast<T>(value);
+    m_argument_pos++;
+    return true;
+}
+template<typename T>
+bool BinaryParser::_parse_unsigned(T& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    const std::size_t pos = m_pos;
+    const std::uint64_t value = _read_unsigned();
+    if(value > std::numeric_limits<T>::max())
+    {
+        m_pos = pos;
+        throw std::out_of_range("integer argument is out of range");
+    }
+    out = static_cast<T>(value);
+    m_argument_pos++;
+    return true;
+}
+
+bool BinaryParser::skip(const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    const ArgumentTypes type = _peek_type();
+    if(__is_signed(type))
+        _read_signed();
+    else if(__is_unsigned(type))
+        _read_unsigned();
+    else if(type == ArgumentTypes::CT_FLOAT || type == ArgumentTypes::CT_DOUBLE)
+        _read_floating();
+    else if(type == ArgumentTypes::CT_BOOL)
+    {
+        if(m_size - m_pos < 2)
+            throw binary_format_error();
+        m_pos += 2;
+    }
+    else if(type == ArgumentTypes::CT_STRING || type == ArgumentTypes::CT_FULL)
+        _read_string(true);
+    else
+        throw binary_format_error();
+    m_argument_pos++;
+    return true;
+}
+bool BinaryParser::parse_string(std::string& out, const bool required)
+{
+    std::string_view value;
+
+    if(!parse_string_view(value, required))
+        return false;
+    out.assign(value.data(), value.size());
+    return true;
+}
+bool BinaryParser::parse_string_view(std::string_view& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    out = _read_string(false);
+    m_argument_pos++;
+    return true;
+}
+bool BinaryParser::parse_full(std::string& out, const bool required)
+{
+    std::string_view value;
+
+    if(!parse_full_view(value, required))
+        return false;
+    out.assign(value.data(), value.size());
+    return true;
+}
+bool BinaryParser::parse_full_view(std::string_view& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    out = _read_string(true);
+    m_argument_pos++;
+    return true;
+}
+bool BinaryParser::parse_tinyint(char& out, const bool required)
+{
+    return _parse_signed<char>(out, required);
+}
+bool BinaryParser::parse_shortint(short& out, const bool required)
+{
+    return _parse_signed<short>(out, required);
+}
+bool BinaryParser::parse_integer(int& out, const bool required)
+{
+    return _parse_signed<int>(out, required);
+}
+bool BinaryParser::parse_bigint(long& out, const bool required)
+{
+    return _parse_signed<long>(out, required);
+}
+bool BinaryParser::parse_unsigned_tinyint(unsigned char& out, const bool required)
+{
+    return _parse_unsigned<unsigned char>(out, required);
+}
+bool BinaryParser::parse_unsigned_shortint(unsigned short& out, const bool required)
+{
+    return _parse_unsigned<unsigned short>(out, required);
+}
+bool BinaryParser::parse_unsigned_integer(unsigned int& out, const bool required)
+{
+    return _parse_unsigned<unsigned int>(out, required);
+}
+bool BinaryParser::parse_unsigned_bigint(unsigned long& out, const bool required)
+{
+    return _parse_unsigned<unsigned long>(out, required);
+}
+bool BinaryParser::parse_float(float& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    const std::size_t pos = m_pos;
+    const double value = _read_floating();
+    if(std::isfinite(value) && std::fabs(value) > std::numeric_limits<float>::max())
+    {
+        m_pos = pos;
+        throw std::out_of_range("float argument is out of range");
+    }
+    out = static_cast<float>(value);
+    m_argument_pos++;
+    return true;
+}
+bool BinaryParser::parse_double(double& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    out = _read_floating();
+    m_argument_pos++;
+    return true;
+}
+bool BinaryParser::parse_bool(bool& out, const bool required)
+{
+    if(!_begin(required))
+        return false;
+
+    if(_peek_type() != ArgumentTypes::CT_BOOL)
+        throw std::invalid_argument("argument is not a bool");
+    if(m_size - m_pos < 2 || static_cast<unsigned char>(m_data[m_pos + 1]) > 1)
+        throw binary_format_error();
+    out = m_data[m_pos + 1] != 0;
+    m_pos += 2;
+    m_argument_pos++;
+    return true;
+}
+
+
+void BinaryArgumentEncoder::_push_string(const ArgumentTypes type, const std::string_view value)
+{
+    m_data.push_back(static_cast<char>(type));
+    varint_write(m_data, value.size());
+    m_data.append(value.data(), value.size());
+}
+void BinaryArgumentEncoder::push_string(const std::string_view value)
+{
+    _push_string(ArgumentTypes::CT_STRING, value);
+}
+void BinaryArgumentEncoder::push_full(const std::string_view value)
+{
+    _push_string(ArgumentTypes::CT_FULL, value);
+}
+void BinaryArgumentEncoder::push_tinyint(const char value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_TINYINT));
+    varint_write_signed(m_data, value);
+}
+void BinaryArgumentEncoder::push_shortint(const short value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_SHORTINT));
+    varint_write_signed(m_data, value);
+}
+void BinaryArgumentEncoder::push_integer(const int value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_INTEGER));
+    varint_write_signed(m_data, value);
+}
+void BinaryArgumentEncoder::push_bigint(const long value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_BIGINT));
+    varint_write_signed(m_data, value);
+}
+void BinaryArgumentEncoder::push_unsigned_tinyint(const unsigned char value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_UTINYINT));
+    varint_write(m_data, value);
+}
+void BinaryArgumentEncoder::push_unsigned_shortint(const unsigned short value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_USHORTINT));
+    varint_write(m_data, value);
+}
+void BinaryArgumentEncoder::push_unsigned_integer(const unsigned int value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_UINTEGER));
+    varint_write(m_data, value);
+}
+void BinaryArgumentEncoder::push_unsigned_bigint(const unsigned long value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_UBIGINT));
+    varint_write(m_data, value);
+}
+void BinaryArgumentEncoder::push_float(const float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_FLOAT));
+    __write_le(m_data, bits, 4);
+}
+void BinaryArgumentEncoder::push_double(const double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_DOUBLE));
+    __write_le(m_data, bits, 8);
+}
+void BinaryArgumentEncoder::push_bool(const bool value)
+{
+    m_data.push_back(static_cast<char>(ArgumentTypes::CT_BOOL));
+    m_data.push_back(value ? 1 : 0);
+}
+const std::string& BinaryArgumentEncoder::get_data() const
+{
+    return m_data;
+}
+std::string BinaryArgumentEncoder::take()
+{
+    std::string data = std::move(m_data);
+
+    m_data.clear();
+    return data;
+}
+void BinaryArgumentEncoder::clear()
+{
+    m_data.clear();
+}
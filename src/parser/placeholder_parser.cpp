@@ -2,8 +2,9 @@
  * parser/placeholder_parser.cpp - Passive parser implementation for non-textual command invocation.
  * Can be useful, for example, when an alternative interface, other than CLI is used,
  * but the toolkit should be shared.
- * This class utilizes deques for each type of command arguments and it isn't used directly
- * by the CommandExecutor, especially not in dispatch_line.
+ * The arguments are kept in a single contiguous array of 16-byte tagged slots, the first few of them
+ * inside the parser itself, and the strings are appended into one arena.
+ * CommandExecutor uses it for invoke(), but not in dispatch_line.
  * Instance can be used to directly invoke commands.
  * For example, using methods such as push_string("Hello World") and push_integer(10), then,
  * passing it into a context as a new parser, the command will receive the arguments
@@ -18,9 +19,43 @@
 #include "argument_types.hpp"
 #include "parser/abstract_parser.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
 using namespace nnwcli;
 
 
+PlaceholderParser::PlaceholderParser() :
+    m_slots(m_inline), m_count(0), m_capacity(inline_slots) {}
+PlaceholderParser::PlaceholderParser(const PlaceholderParser& other) :
+    AbstractParser(other), m_slots(m_inline), m_count(0), m_capacity(inline_slots)
+{
+    *this = other;
+}
+PlaceholderParser& PlaceholderParser::operator=(const PlaceholderParser& other)
+{
+    if(this == &other)
+        return *this;
+
+    AbstractParser::operator=(other);
+    if(other.m_count > m_capacity)
+    {
+        m_heap = std::make_unique<_Slot[]>(other.m_count);
+        m_slots = m_heap.get();
+        m_capacity = other.m_count;
+    }
+    std::copy(other.m_slots, other.m_slots + other.m_count, m_slots);
+    m_count = other.m_count;
+    m_arena = other.m_arena;
+    m_full_string = other.m_full_string;
+    m_custom = other.m_custom;
+    return *this;
+}
+
 const std::string& PlaceholderParser::get_full_string() const
 {
     return m_full_string;
@@ -36,205 +71,251 @@ void PlaceholderParser::set_full_string(const char* value)
 
 bool PlaceholderParser::exhausted() const
 {
-    return m_pos >= m_queue_types.size();
+    return m_argument_pos >= m_count;
 }
 void PlaceholderParser::_throw_if_exhausted()
 {
-    if(m_pos >= m_queue_types.size())
+    if(m_argument_pos >= m_count)
         throw not_enough_arguments();
 }
-std::deque<std::pair<ArgumentTypes, std::size_t>>* PlaceholderParser::get_types_queue()
-{
-    return &m_queue_types;
-}
-std::deque<std::string>* PlaceholderParser::get_string_queue()
+bool PlaceholderParser::skip(const bool required)
 {
-    return &m_queue_string;
-}
-std::deque<char>* PlaceholderParser::get_tinyint_queue()
-{
-    return &m_queue_tinyint;
-}
-std::deque<short>* PlaceholderParser::get_shortint_queue()
-{
-    return &m_queue_shortint;
+    if(required)
+        _throw_if_exhausted();
+    else if(exhausted())
+        return false;
+
+    m_argument_pos++;
+    return true;
 }
-std::deque<int>* PlaceholderParser::get_integer_queue()
+std::size_t PlaceholderParser::get_count() const
 {
-    return &m_queue_integer;
+    return m_count;
 }
-std::deque<long>* PlaceholderParser::get_bigint_queue()
+ArgumentTypes PlaceholderParser::get_type(const std::size_t index) const
 {
-    return &m_queue_bigint;
+    return m_slots[index].m_type;
 }
-std::deque<float>* PlaceholderParser::get_float_queue()
+
+PlaceholderParser::_Slot& PlaceholderParser::_push(const ArgumentTypes type)
 {
-    return &m_queue_float;
+    if(m_count == m_capacity)
+    {
+        const std::size_t capacity = m_capacity * 2;
+        std::unique_ptr<_Slot[]> heap = std::make_unique<_Slot[]>(capacity);
+
+        std::copy(m_slots, m_slots + m_count, heap.get());
+        m_heap = std::move(heap);
+        m_slots = m_heap.get();
+        m_capacity = capacity;
+    }
+
+    _Slot& slot = m_slots[m_count++];
+    slot.m_type = type;
+    slot.m_unsigned = 0;
+    return slot;
 }
-std::deque<double>* PlaceholderParser::get_double_queue()
+void PlaceholderParser::push_string(const std::string& value)
 {
-    return &m_queue_double;
+    push_string(std::string_view(value));
 }
-std::deque<bool>* PlaceholderParser::get_bool_queue()
+void PlaceholderParser::push_string(const std::string_view value)
 {
-    return &m_queue_bool;
-}
+    if(m_arena.size() + value.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("placeholder string arena is limited to 4 GiB");
 
-void PlaceholderParser::push_string(const std::string& value)
+    _Slot& slot = _push(ArgumentTypes::CT_STRING);
+    slot.m_string.m_offset = static_cast<std::uint32_t>(m_arena.size());
+    slot.m_string.m_size = static_cast<std::uint32_t>(value.size());
+    m_arena.append(value.data(), value.size());
+}
+void PlaceholderParser::push_string(const char* const value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_STRING, m_queue_string.size()});
-    m_queue_string.push_back(value);
+    push_string(std::string_view(value));
 }
 void PlaceholderParser::push_tinyint(const char value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_TINYINT, m_queue_tinyint.size()});
-    m_queue_tinyint.push_back(value);
+    _push(ArgumentTypes::CT_TINYINT).m_signed = value;
 }
 void PlaceholderParser::push_shortint(const short value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_SHORTINT, m_queue_shortint.size()});
-    m_queue_shortint.push_back(value);
+    _push(ArgumentTypes::CT_SHORTINT).m_signed = value;
 }
 void PlaceholderParser::push_integer(const int value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_INTEGER, m_queue_integer.size()});
-    m_queue_integer.push_back(value);
+    _push(ArgumentTypes::CT_INTEGER).m_signed = value;
 }
 void PlaceholderParser::push_bigint(const long value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_BIGINT, m_queue_bigint.size()});
-    m_queue_bigint.push_back(value);
+    _push(ArgumentTypes::CT_BIGINT).m_signed = value;
 }
 void PlaceholderParser::push_unsigned_tinyint(const unsigned char value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_UTINYINT, m_queue_tinyint.size()});
-    m_queue_tinyint.push_back(value);
+    _push(ArgumentTypes::CT_UTINYINT).m_unsigned = value;
 }
 void PlaceholderParser::push_unsigned_shortint(const unsigned short value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_USHORTINT, m_queue_shortint.size()});
-    m_queue_shortint.push_back(value);
+    _push(ArgumentTypes::CT_USHORTINT).m_unsigned = value;
 }
 void PlaceholderParser::push_unsigned_integer(const unsigned int value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_UINTEGER, m_queue_integer.size()});
-    m_queue_integer.push_back(value);
+    _push(ArgumentTypes::CT_UINTEGER).m_unsigned = value;
 }
 void PlaceholderParser::push_unsigned_bigint(const unsigned long value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_UBIGINT, m_queue_bigint.size()});
-    m_queue_bigint.push_back(value);
+    _push(ArgumentTypes::CT_UBIGINT).m_unsigned = value;
 }
 void PlaceholderParser::push_float(const float value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_FLOAT, m_queue_float.size()});
-    m_queue_float.push_back(value);
+    _push(ArgumentTypes::CT_FLOAT).m_float = value;
 }
 void PlaceholderParser::push_double(const double value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_DOUBLE, m_queue_double.size()});
-    m_queue_double.push_back(value);
+    _push(ArgumentTypes::CT_DOUBLE).m_double = value;
 }
 void PlaceholderParser::push_bool(const bool value)
 {
-    m_queue_types.push_back(
-            {ArgumentTypes::CT_BOOL, m_queue_bool.size()});
-    m_queue_bool.push_back(value);
+    _push(ArgumentTypes::CT_BOOL).m_bool = value;
+}
+void PlaceholderParser::push_custom(CustomValue value)
+{
+    _push(ArgumentTypes::CT_STRING_CUSTOM).m_unsigned = m_custom.size();
+    m_custom.push_back(std::move(value));
 }
 void PlaceholderParser::clear()
 {
-    m_queue_types.clear();
-    m_queue_string.clear();
-    m_queue_tinyint.clear();
-    m_queue_shortint.clear();
-    m_queue_integer.clear();
-    m_queue_bigint.clear();
-    m_queue_float.clear();
-    m_queue_double.clear();
-    m_queue_bool.clear();
-    m_queue_custom.clear();
+    // slots hold no resources, so nothing has to be destroyed
+    m_count = 0;
+    m_arena.clear();
     m_full_string.clear();
+    m_custom.clear();
+    m_pos = 0;
+    m_argument_pos = 0;
 }
 
-template<typename T>
-bool PlaceholderParser::pick_from_queue(T& out, ArgumentTypes expected_type, std::deque<T>& deque, const bool required)
-{
-    if(m_queue_types.empty()|| m_argument_pos > m_queue_types.size() - 1 ||
-            m_queue_types[m_argument_pos].first != expected_type)
+// arguments of the same family are interchangeable, like their textual forms
+static int __family(const ArgumentTypes type)
+{
+    if(type >= ArgumentTypes::CT_TINYINT && type <= ArgumentTypes::CT_BIGINT)
+        return 1;
+    if(type >= ArgumentTypes::CT_UTINYINT && type <= ArgumentTypes::CT_UBIGINT)
+        return 2;
+    if(type == ArgumentTypes::CT_FLOAT || type == ArgumentTypes::CT_DOUBLE)
+        return 3;
+    if(type == ArgumentTypes::CT_STRING_CUSTOM)
+        return 5;
+    return type == ArgumentTypes::CT_BOOL ? 4 : 0;
+}
+const PlaceholderParser::_Slot* PlaceholderParser::_pick(const ArgumentTypes expected_type, const bool required)
+{
+    if(m_argument_pos >= m_count)
     {
         if(required)
             throw not_enough_arguments();
         else
-            return false;
+            return nullptr;
     }
 
-    out = deque[m_queue_types[m_argument_pos].second];
+    const _Slot* const slot = &m_slots[m_argument_pos];
+    if(__family(slot->m_type) != __family(expected_type))
+        throw std::invalid_argument(std::string("expected an argument of type ") + argtype_to_name(expected_type));
+    return slot;
+}
+template<typename T>
+bool PlaceholderParser::_pick_integer(T& out, const ArgumentTypes expected_type, const bool required)
+{
+    const _Slot* const slot = _pick(expected_type, required);
+    if(!slot)
+        return false;
 
+    if constexpr(std::is_signed_v<T>)
+    {
+        if(slot->m_signed < std::numeric_limits<T>::min() || slot->m_signed > std::numeric_limits<T>::max())
+            throw std::out_of_range("integer argument is out of range");
+        out = static_cast<T>(slot->m_signed);
+    }
+    else
+    {
+        if(slot->m_unsigned > std::numeric_limits<T>::max())
+            throw std::out_of_range("integer argument is out of range");
+        out = static_cast<T>(slot->m_unsigned);
+    }
     m_argument_pos++;
     return true;
 }
 bool PlaceholderParser::parse_string(std::string& out, const bool required) 
 {
-    return pick_from_queue<std::string>(out, ArgumentTypes::CT_STRING, m_queue_string, required);
+    const _Slot* const slot = _pick(ArgumentTypes::CT_STRING, required);
+    if(!slot)
+        return false;
+    out.assign(m_arena, slot->m_string.m_offset, slot->m_string.m_size);
+    m_argument_pos++;
+    return true;
 }
 bool PlaceholderParser::parse_tinyint(char& out, const bool required) 
 {
-    return pick_from_queue<char>(out, ArgumentTypes::CT_TINYINT, m_queue_tinyint, required);
+    return _pick_integer(out, ArgumentTypes::CT_TINYINT, required);
 }
 bool PlaceholderParser::parse_shortint(short& out, const bool required) 
 {
-    return pick_from_queue<short>(out, ArgumentTypes::CT_SHORTINT, m_queue_shortint, required);
+    return _pick_integer(out, ArgumentTypes::CT_SHORTINT, required);
 }
 bool PlaceholderParser::parse_integer(int& out, const bool required) 
 {
-    return pick_from_queue<int>(out, ArgumentTypes::CT_INTEGER, m_queue_integer, required);
+    return _pick_integer(out, ArgumentTypes::CT_INTEGER, required);
 }
 bool PlaceholderParser::parse_bigint(long& out, const bool required) 
 {
-    return pick_from_queue<long>(out, ArgumentTypes::CT_BIGINT, m_queue_bigint, required);
+    return _pick_integer(out, ArgumentTypes::CT_BIGINT, required);
 }
 bool PlaceholderParser::parse_unsigned_tinyint(unsigned char& out, const bool required) 
 {
-    return pick_from_queue<unsigned char>(out, ArgumentTypes::CT_UTINYINT,
-            reinterpret_cast<std::deque<unsigned char>&>(m_queue_tinyint), required);
+    return _pick_integer(out, ArgumentTypes::CT_UTINYINT, required);
 }
 bool PlaceholderParser::parse_unsigned_shortint(unsigned short& out, const bool required) 
 {
-    return pick_from_queue<unsigned short>(out, ArgumentTypes::CT_USHORTINT,
-            reinterpret_cast<std::deque<unsigned short>&>(m_queue_shortint), required);
+    return _pick_integer(out, ArgumentTypes::CT_USHORTINT, required);
 }
 bool PlaceholderParser::parse_unsigned_integer(unsigned int& out, const bool required) 
 {
-    return pick_from_queue<unsigned int>(out, ArgumentTypes::CT_UINTEGER,
-            reinterpret_cast<std::deque<unsigned int>&>(m_queue_integer), required);
+    return _pick_integer(out, ArgumentTypes::CT_UINTEGER, required);
 }
 bool PlaceholderParser::parse_unsigned_bigint(unsigned long& out, const bool required) 
 {
-    return pick_from_queue<unsigned long>(out, ArgumentTypes::CT_UBIGINT,
-            reinterpret_cast<std::deque<unsigned long>&>(m_queue_bigint), required);
+    return _pick_integer(out, ArgumentTypes::CT_UBIGINT, required);
 }
 bool PlaceholderParser::parse_float(float& out, const bool required) 
 {
-    return pick_from_queue<float>(out, ArgumentTypes::CT_FLOAT, m_queue_float, required);
+    const _Slot* const slot = _pick(ArgumentTypes::CT_FLOAT, required);
+    if(!slot)
+        return false;
+
+    if(slot->m_type == ArgumentTypes::CT_FLOAT)
+        out = slot->m_float;
+    else if(std::isfinite(slot->m_double) && std::fabs(slot->m_double) > std::numeric_limits<float>::max())
+        throw std::out_of_range("float argument is out of range");
+    else
+        out = static_cast<float>(slot->m_double);
+    m_argument_pos++;
+    return true;
 }
 bool PlaceholderParser::parse_double(double& out, const bool required) 
 {
-    return pick_from_queue<double>(out, ArgumentTypes::CT_DOUBLE, m_queue_double, required);
+    const _Slot* const slot = _pick(ArgumentTypes::CT_DOUBLE, required);
+    if(!slot)
+        return false;
+    out = slot->m_type == ArgumentTypes::CT_FLOAT ? slot->m_float : slot->m_double;
+    m_argument_pos++;
+    return true;
 }
 bool PlaceholderParser::parse_bool(bool& out, const bool required) 
 {
-    return pick_from_queue<bool>(out, ArgumentTypes::CT_BOOL, m_queue_bool, required);
+    const _Slot* const slot = _pick(ArgumentTypes::CT_BOOL, required);
+    if(!slot)
+        return false;
+    out = slot->m_bool;
+    m_argument_pos++;
+    return true;
 }
 bool PlaceholderParser::parse_full(std::string& out, const bool required) 
 {
@@ -251,3 +332,19 @@ bool PlaceholderParser::parse_full(std::string& out, const bool required)
     m_argument_pos++;
     return true;
 }
+bool PlaceholderParser::parse_custom(CustomValue& out, const CustomTypeId type, const bool required)
+{
+    if(m_argument_pos < m_count && m_slots[m_argument_pos].m_type == ArgumentTypes::CT_STRING)
+        return AbstractParser::parse_custom(out, type, required);
+
+    const _Slot* const slot = _pick(ArgumentTypes::CT_STRING_CUSTOM, required);
+    if(!slot)
+        return false;
+
+    const CustomValue& value = m_custom[slot->m_unsigned];
+    if(value.get_type() != type)
+        throw std::invalid_argument("custom argument is of another type");
+    out = value;
+    m_argument_pos++;
+    return true;
+}
@@ -0,0 +1,509 @@
+/**
+ * pattern.cpp - Patterns of the CT_PATTERN arguments, compiled into a table-driven DFA.
+ * The pattern is parsed into a Thompson NFA, which is turned into a DFA by the subset construction.
+ * Octets are grouped into classes first, so the subsets are computed once per class, not per octet.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "pattern.hpp"
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <utility>
+
+using namespace nnwcli;
+
+// exceptions
+
+const char* pattern_error::what() const noexcept
+{
+    return "pattern is invalid or too complex";
+}
+
+
+// repetition counts above it are rejected, since every repetition is a copy of the automaton
+static const unsigned int __max_repetition = 255;
+
+struct __NfaNode
+{
+    std::bitset<256>    m_set;
+    // octet nodes follow m_out1 on an octet of m_set, epsilon nodes follow both outs freely
+    bool                m_epsilon;
+    int                 m_out1;
+    int                 m_out2;
+};
+struct __Fragment
+{
+    int m_start;
+    // epsilon node without outs yet
+    int m_end;
+};
+
+class __PatternParser
+{
+    const std::string&  m_source;
+    std::size_t         m_pos;
+
+    bool _at(const char c) const
+    {
+        return m_pos < m_source.size() && m_source[m_pos] == c;
+    }
+    int _node(const bool epsilon, const std::bitset<256>& set = std::bitset<256>())
+    {
+        if(m_nodes.size() >= Pattern::max_nfa_nodes)
+            throw pattern_error(m_pos);
+        m_nodes.push_back({set, epsilon, -1, -1});
+        return static_cast<int>(m_nodes.size() - 1);
+    }
+    void _link(const int from, const int to)
+    {
+        __NfaNode& node = m_nodes[from];
+
+        if(node.m_out1 < 0)
+            node.m_out1 = to;
+        else
+            node.m_out2 = to;
+    }
+    __Fragment _empty()
+    {
+        const int end = _node(true);
+        return {end, end};
+    }
+    __Fragment _octets(const std::bitset<256>& set)
+    {
+        const int end = _node(true);
+        const int start = _node(false, set);
+
+        m_nodes[start].m_out1 = end;
+        return {start, end};
+    }
+    __Fragment _concat(const __Fragment first, const __Fragment second)
+    {
+        _link(first.m_end, second.m_start);
+        return {first.m_start, second.m_end};
+    }
+    __Fragment _alternate(const __Fragment first, const __Fragment second)
+    {
+        const int start = _node(true);
+        const int end = _node(true);
+
+        _link(start, first.m_start);
+        _link(start, second.m_start);
+        _link(first.m_end, end);
+        _link(second.m_end, end);
+        return {start, end};
+    }
+    __Fragment _optional(const __Fragment fragment)
+    {
+        const int start = _node(true);
+        const int end = _node(true);
+
+        _link(start, fragment.m_start);
+        _link(start, end);
+        _link(fragment.m_end, end);
+        return {start, end};
+    }
+    __Fragment _star(const __Fragment fragment)
+    {
+        const int start = _node(true);
+        const int end = _node(true);
+
+        _link(start, fragment.m_start);
+        _link(start, end);
+        _link(fragment.m_end, fragment.m_start);
+        _link(fragment.m_end, end);
+        return {start, end};
+    }
+    __Fragment _plus(const __Fragment fragment)
+    {
+        const int end = _node(true);
+
+        _link(fragment.m_end, fragment.m_start);
+        _link(fragment.m_end, end);
+        return {fragment.m_start, end};
+    }
+
+    // \d \w \s and their negations, or false when the escape is not a class
+    static bool _class_escape(const char c, std::bitset<256>& set)
+    {
+        std::bitset<256> result;
+
+        switch(c | 0x20)
+        {
+        case 'd':
+            for(int i = '0'; i <= '9'; i++)
+                result.set(i);
+            break;
+        case 'w':
+            for(int i = '0'; i <= '9'; i++)
+                result.set(i);
+            for(int i = 'a'; i <= 'z'; i++)
+                result.set(i).set(i - 0x20);
+            result.set('_');
+            break;
+        case 's':
+            for(const char space : {' ', '\t', '\n', '\r', '\f', '\v'})
+                result.set(static_cast<unsigned char>(space));
+            break;
+        default:
+            return false;
+        }
+        set = c >= 'a' ? result : ~result;
+        return true;
+    }
+    // single octet of an escape sequence, at m_pos after the backslash
+    unsigned char _escaped_octet()
+    {
+        if(m_pos >= m_source.size())
+            throw pattern_error(m_pos);
+
+        const char c = m_source[m_pos++];
+        switch(c)
+        {
+        case 'n':
+            return '\n';
+        case 't':
+            return '\t';
+        case 'r':
+            return '\r';
+        case 'f':
+            return '\f';
+        case 'v':
+            return '\v';
+        }
+        // letters and digits are reserved for the escapes that may come later
+        if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+            throw pattern_error(m_pos - 1);
+        return static_cast<unsigned char>(c);
+    }
+    std::bitset<256> _class()
+    {
+        std::bitset<256> set;
+        const bool negated = _at('^');
+        bool first = true;
+
+        if(negated)
+            m_pos++;
+        while(m_pos < m_source.size() && (first || m_source[m_pos] != ']'))
+        {
+            unsigned char low;
+
+            first = false;
+            if(m_source[m_pos] == '\\')
+            {
+                std::bitset<256> escaped;
+
+                m_pos++;
+                if(m_pos < m_source.size() && _class_escape(m_source[m_pos], escaped))
+                {
+                    m_pos++;
+                    set |= escaped;
+                    continue;
+                }
+                low = _escaped_octet();
+            }
+            else
+                low = static_cast<unsigned char>(m_source[m_pos++]);
+
+            unsigned char high = low;
+            if(_at('-') && m_pos + 1 < m_source.size() && m_source[m_pos + 1] != ']')
+            {
+                m_pos++;
+                if(m_source[m_pos] == '\\')
+                {
+                    m_pos++;
+                    high = _escaped_octet();
+                }
+                else
+                    high = static_cast<unsigned char>(m_source[m_pos++]);
+                if(high < low)
+                    throw pattern_error(m_pos - 1);
+            }
+            for(unsigned int c = low; c <= high; c++)
+                set.set(c);
+        }
+        if(!_at(']'))
+            throw pattern_error(m_pos);
+        m_pos++;
+        return negated ? ~set : set;
+    }
+    __Fragment _atom()
+    {
+        if(m_pos >= m_source.size())
+            throw pattern_error(m_pos);
+
+        const char c = m_source[m_pos++];
+        switch(c)
+        {
+        case '(':
+        {
+            const __Fragment group = _alternation();
+            if(!_at(')'))
+                throw pattern_error(m_pos);
+            m_pos++;
+            return group;
+        }
+        case '[':
+            return _octets(_class());
+        case '.':
+            return _octets(std::bitset<256>().set());
+        case '\\':
+        {
+            std::bitset<256> set;
+            if(m_pos < m_source.size() && _class_escape(m_source[m_pos], set))
+            {
+                m_pos++;
+                return _octets(set);
+            }
+            return _octets(std::bitset<256>().set(_escaped_octet()));
+        }
+        // the whole argument is always matched, there is nothing to anchor
+        case '^':
+        case '$':
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+        case ')':
+        case '|':
+            throw pattern_error(m_pos - 1);
+        default:
+            return _octets(std::bitset<256>().set(static_cast<unsigned char>(c)));
+        }
+    }
+    // the atom at start, once more, for the copies made by the repetitions
+    __Fragment _atom_at(const std::size_t start)
+    {
+        const std::size_t pos = m_pos;
+
+        m_pos = start;
+        const __Fragment fragment = _atom();
+        m_pos = pos;
+        return fragment;
+    }
+    unsigned int _number()
+    {
+        unsigned int value = 0;
+        const std::size_t start = m_pos;
+
+        while(m_pos < m_source.size() && m_source[m_pos] >= '0' && m_source[m_pos] <= '9')
+        {
+            value = value * 10 + (m_source[m_pos++] - '0');
+            if(value > __max_repetition)
+                throw pattern_error(start);
+        }
+        if(m_pos == start)
+            throw pattern_error(m_pos);
+        return value;
+    }
+    __Fragment _repetition()
+    {
+        const std::size_t start = m_pos;
+        __Fragment fragment = _atom();
+
+        if(m_pos >= m_source.size())
+            return fragment;
+        switch(m_source[m_pos])
+        {
+        case '*':
+            m_pos++;
+            return _star(fragment);
+        case '+':
+            m_pos++;
+            return _plus(fragment);
+        case '?':
+            m_pos++;
+            return _optional(fragment);
+        case '{':
+            break;
+        default:
+            return fragment;
+        }
+
+        m_pos++;
+        const unsigned int min = _number();
+        unsigned int max = min;
+        bool unbounded = false;
+        if(_at(','))
+        {
+            m_pos++;
+            if(_at('}'))
+                unbounded = true;
+            else
+                max = _number();
+        }
+        if(!_at('}') || max < min)
+            throw pattern_error(m_pos);
+        m_pos++;
+
+        // the atom parsed above is the first copy
+        __Fragment result = min ? fragment : _empty();
+        for(unsigned int i = 1; i < min; i++)
+            result = _concat(result, _atom_at(start));
+        if(unbounded)
+            result = _concat(result, _star(min ? _atom_at(start) : fragment));
+        else
+        {
+            for(unsigned int i = min; i < max; i++)
+                result = _concat(result, _optional(!min && i == 0 ? fragment : _atom_at(start)));
+        }
+        return result;
+    }
+    __Fragment _concatenation()
+    {
+        __Fragment result = _empty();
+
+        while(m_pos < m_source.size() && m_source[m_pos] != '|' && m_source[m_pos] != ')')
+            result = _concat(result, _repetition());
+        return result;
+    }
+    __Fragment _alternation()
+    {
+        __Fragment result = _concatenation();
+
+        while(_at('|'))
+        {
+            m_pos++;
+            result = _alternate(result, _concatenation());
+        }
+        return result;
+    }
+public:
+    std::vector<__NfaNode> m_nodes;
+
+    __PatternParser(const std::string& source) :
+        m_source(source), m_pos(0) {}
+
+    __Fragment parse()
+    {
+        const __Fragment result = _alternation();
+
+        // a closing parenthesis without an opening one
+        if(m_pos != m_source.size())
+            throw pattern_error(m_pos);
+        return result;
+    }
+};
+
+static void __epsilon_closure(const std::vector<__NfaNode>& nodes, std::vector<int>& set)
+{
+    std::vector<int> stack(set);
+    std::vector<bool> seen(nodes.size());
+
+    for(const int node : set)
+        seen[node] = true;
+    while(!stack.empty())
+    {
+        const __NfaNode& node = nodes[stack.back()];
+
+        stack.pop_back();
+        if(!node.m_epsilon)
+            continue;
+        for(const int out : {node.m_out1, node.m_out2})
+        {
+            if(out >= 0 && !seen[out])
+            {
+                seen[out] = true;
+                set.push_back(out);
+                stack.push_back(out);
+            }
+        }
+    }
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+}
+
+
+Pattern::Pattern(std::string source) :
+    m_source(std::move(source))
+{
+    __PatternParser parser(m_source);
+    const __Fragment nfa = parser.parse();
+    const std::vector<__NfaNode>& nodes = parser.m_nodes;
+
+    // octets with the same membership in every set of the NFA can't be told apart
+    std::map<std::string, std::uint8_t> signatures;
+    std::vector<unsigned char> representatives;
+    for(unsigned int octet = 0; octet < 256; octet++)
+    {
+        std::string signature;
+
+        for(const __NfaNode& node : nodes)
+        {
+            if(!node.m_epsilon)
+                signature.push_back(node.m_set[octet] ? '1' : '0');
+        }
+        auto found = signatures.emplace(std::move(signature), static_cast<std::uint8_t>(representatives.size()));
+        if(found.second)
+            representatives.push_back(static_cast<unsigned char>(octet));
+        m_classes[octet] = found.first->second;
+    }
+    m_class_count = representatives.size();
+
+    // the subset construction, state 0 is the empty subset
+    std::vector<std::vector<int>> states{{}};
+    std::map<std::vector<int>, std::uint32_t> ids{{{}, dead_state}};
+    auto state_of = [&](std::vector<int>&& set) -> std::uint32_t
+    {
+        __epsilon_closure(nodes, set);
+        auto found = ids.find(set);
+        if(found != ids.end())
+            return found->second;
+        if(states.size() >= max_dfa_states)
+            throw pattern_error(m_source.size());
+
+        const std::uint32_t id = static_cast<std::uint32_t>(states.size());
+        ids.emplace(set, id);
+        states.push_back(std::move(set));
+        return id;
+    };
+
+    m_start = state_of({nfa.m_start});
+    for(std::size_t state = 0; state < states.size(); state++)
+    {
+        m_transitions.resize((state + 1) * m_class_count, dead_state);
+        // states grows below, so the subset is copied
+        const std::vector<int> current = states[state];
+
+        m_accepting.push_back(std::binary_search(current.begin(), current.end(), nfa.m_end));
+        for(std::size_t octet_class = 0; octet_class < m_class_count; octet_class++)
+        {
+            std::vector<int> next;
+
+            for(const int node : current)
+            {
+                if(!nodes[node].m_epsilon && nodes[node].m_set[representatives[octet_class]])
+                    next.push_back(nodes[node].m_out1);
+            }
+            if(!next.empty())
+                m_transitions[state * m_class_count + octet_class] = state_of(std::move(next));
+        }
+    }
+}
+bool Pattern::matches(const std::string_view text) const
+{
+    std::uint32_t state = m_start;
+
+    for(const char c : text)
+    {
+        state = step(state, static_cast<unsigned char>(c));
+        if(state == dead_state)
+            return false;
+    }
+    return accepts(state);
+}
+const std::string& Pattern::get_source() const
+{
+    return m_source;
+}
+std::size_t Pattern::get_state_count() const
+{
+    return m_accepting.size();
+}
+std::size_t Pattern::get_class_count() const
+{
+    return m_class_count;
+}
@@ -0,0 +1,285 @@
+/**
+ * record.cpp - Structured output of the commands, rendered by a serializer selected per context.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "record.hpp"
+#include "context.hpp"
+#include "util/varint.hpp"
+#include <cmath>
+#include <cstring>
+
+using namespace nnwcli;
+
+// exceptions
+
+const char* record_error::what() const noexcept
+{
+    return "record fields must be written between begin_record() and end_record()";
+}
+const char* record_format_error::what() const noexcept
+{
+    return "malformed binary record";
+}
+
+
+// writes the value the same way the << operator of the context would
+static void __write_plain(CommandExecutorContext& ctx, const RecordValue& value)
+{
+    switch(value.m_type)
+    {
+    case RecordValue::RT_STRING:
+        ctx << value.m_string;
+        break;
+    case RecordValue::RT_SIGNED:
+        ctx << static_cast<long long>(value.m_signed);
+        break;
+    case RecordValue::RT_UNSIGNED:
+        ctx << static_cast<unsigned long long>(value.m_unsigned);
+        break;
+    case RecordValue::RT_DOUBLE:
+        ctx << value.m_double;
+        break;
+    case RecordValue::RT_BOOL:
+        ctx << value.m_bool;
+        break;
+    }
+}
+
+TextRecordSerializer::TextRecordSerializer() : m_first(true) {}
+
+void TextRecordSerializer::begin_record(CommandExecutorContext&, std::string_view)
+{
+    m_first = true;
+}
+void TextRecordSerializer::field(CommandExecutorContext& ctx, const std::string_view key, const RecordValue& value)
+{
+    if(!m_first)
+        ctx.write(", ", 2);
+    m_first = false;
+    ctx << key;
+    ctx.write(": ", 2);
+    __write_plain(ctx, value);
+}
+void TextRecordSerializer::end_record(CommandExecutorContext& ctx)
+{
+    ctx << '\n';
+}
+
+
+// writes a quoted JSON string, copying the runs that need no escaping at once
+static void __write_json_string(CommandExecutorContext& ctx, const std::string_view value)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    std::size_t start = 0;
+
+    ctx << '"';
+    for(std::size_t i = 0; i < value.size(); i++)
+    {
+        const unsigned char c = value[i];
+        char escape[6] = {'\\', 0, '0', '0', 0, 0};
+        std::size_t escape_size = 2;
+
+        if(c == '"' || c == '\\')
+            escape[1] = c;
+        else if(c == '\n')
+            escape[1] = 'n';
+        else if(c == '\r')
+            escape[1] = 'r';
+        else if(c == '\t')
+            escape[1] = 't';
+        else if(c < 0x20)
+        {
+            escape[1] = 'u';
+            escape[4] = hex_digits[c >> 4];
+            escape[5] = hex_digits[c & 0xF];
+            escape_size = 6;
+        }
+        else
+            continue;
+
+        if(i > start)
+            ctx.write(value.data() + start, i - start);
+        ctx.write(escape, escape_size);
+        start = i + 1;
+    }
+    if(value.size() > start)
+        ctx.write(value.data() + start, value.size() - start);
+    ctx << '"';
+}
+
+void JsonLinesSerializer::begin_record(CommandExecutorContext& ctx, const std::string_view name)
+{
+    ctx.write("{\"record\":", 10);
+    __write_json_string(ctx, name);
+}
+void JsonLinesSerializer::field(CommandExecutorContext& ctx, const std::string_view key, const RecordValue& value)
+{
+    ctx << ',';
+    __write_json_string(ctx, key);
+    ctx << ':';
+    if(value.m_type == RecordValue::RT_STRING)
+        __write_json_string(ctx, value.m_string);
+    else if(value.m_type == RecordValue::RT_DOUBLE && !std::isfinite(value.m_double))
+        ctx.write("null", 4);
+    else
+        __write_plain(ctx, value);
+}
+void JsonLinesSerializer::end_record(CommandExecutorContext& ctx)
+{
+    ctx.write("}\n", 2);
+}
+
+
+static void __append_string(std::string& out, const std::string_view value)
+{
+    varint_write(out, value.size());
+    out.append(value.data(), value.size());
+}
+
+void BinaryRecordSerializer::begin_record(CommandExecutorContext&, const std::string_view name)
+{
+    m_frame.clear();
+    __append_string(m_frame, name);
+}
+void BinaryRecordSerializer::field(CommandExecutorContext&, const std::string_view key, const RecordValue& value)
+{
+    m_frame.push_back(static_cast<char>(value.m_type));
+    __append_string(m_frame, key);
+    switch(value.m_type)
+    {
+    case RecordValue::RT_STRING:
+        __append_string(m_frame, value.m_string);
+        break;
+    case RecordValue::RT_SIGNED:
+        varint_write_signed(m_frame, value.m_signed);
+        break;
+    case RecordValue::RT_UNSIGNED:
+        varint_write(m_frame, value.m_unsigned);
+        break;
+    case RecordValue::RT_DOUBLE:
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value.m_double, sizeof(bits));
+        for(int i = 0; i < 8; i++, bits >>= 8)
+            m_frame.push_back(static_cast<char>(bits & 0xFF));
+        break;
+    }
+    case RecordValue::RT_BOOL:
+        m_frame.push_back(value.m_bool ? 1 : 0);
+        break;
+    }
+}
+void BinaryRecordSerializer::end_record(CommandExecutorContext& ctx)
+{
+    m_prefix.clear();
+    varint_write(m_prefix, m_frame.size());
+    ctx.write(m_prefix.data(), m_prefix.size());
+    ctx.write(m_frame.data(), m_frame.size());
+}
+
+
+std::shared_ptr<RecordSerializer> nnwcli::make_record_serializer(const RecordFormat format)
+{
+    switch(format)
+    {
+    case RF_JSON_LINES:
+        return std::make_shared<JsonLinesSerializer>();
+    case RF_BINARY:
+        return std::make_shared<BinaryRecordSerializer>();
+    default:
+        return std::make_shared<TextRecordSerializer>();
+    }
+}
+
+// reads a varint-prefixed string from data[pos..end), advancing pos
+static std::string_view __read_string(const char* const data, std::size_t& pos, const std::size_t end)
+{
+    std::uint64_t size;
+    const std::size_t read = varint_read(data + pos, end - pos, size);
+
+    if(!read || size > end - pos - read)
+        throw record_format_error();
+    pos += read;
+    const std::string_view result(data + pos, size);
+    pos += size;
+    return result;
+}
+
+std::size_t nnwcli::decode_binary_record(const char* const data, const std::size_t n, DecodedRecord& record)
+{
+    std::uint64_t frame_size;
+    std::size_t pos = varint_read(data, n, frame_size);
+
+    if(!pos)
+    {
+        // a prefix longer than 10 octets can't be valid
+        if(n >= 10)
+            throw record_format_error();
+        return 0;
+    }
+    if(frame_size > n - pos)
+        return 0;
+
+    const std::size_t end = pos + frame_size;
+    record.m_fields.clear();
+    record.m_name = __read_string(data, pos, end);
+    while(pos < end)
+    {
+        const unsigned char type = data[pos++];
+        const std::string_view key = __read_string(data, pos, end);
+        RecordValue value;
+
+        switch(type)
+        {
+        case RecordValue::RT_STRING:
+            value = RecordValue(__read_string(data, pos, end));
+            break;
+        case RecordValue::RT_SIGNED:
+        {
+            std::int64_t signed_value;
+            const std::size_t read = varint_read_signed(data + pos, end - pos, signed_value);
+            if(!read)
+                throw record_format_error();
+            pos += read;
+            value = RecordValue(signed_value);
+            break;
+        }
+        case RecordValue::RT_UNSIGNED:
+        {
+            std::uint64_t unsigned_value;
+            const std::size_t read = varint_read(data + pos, end - pos, unsigned_value);
+            if(!read)
+                throw record_format_error();
+            pos += read;
+            value = RecordValue(unsigned_value);
+            break;
+        }
+        case RecordValue::RT_DOUBLE:
+        {
+            if(end - pos < 8)
+                throw record_format_error();
+            std::uint64_t bits = 0;
+            for(int i = 7; i >= 0; i--)
+                bits = (bits << 8) | static_cast<unsigned char>(data[pos + i]);
+            double double_value;
+            std::memcpy(&double_value, &bits, sizeof(bits));
+            pos += 8;
+            value = RecordValue(double_value);
+            break;
+        }
+        case RecordValue::RT_BOOL:
+            if(pos >= end)
+                throw record_format_error();
+            value = RecordValue(data[pos++] != 0);
+            break;
+        default:
+            throw record_format_error();
+        }
+        record.m_fields.emplace_back(key, value);
+    }
+    return end;
+}
@@ -1,4 +1,18 @@
 #include "util/utf8.hpp"
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNWCLI_UTF8_SSE2
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NNWCLI_UTF8_X86
+#include <immintrin.h>
+#endif
 
 const char* nnwcli::unicode_too_short::what() const noexcept
 {
@@ -89,3 +103,615 @@ char nnwcli::utf8_write_octets(char out[4], const unsigned int value)
     }
     return 0;
 }
+
+
+// validation
+
+// the sequence at i, its length when it is valid, otherwise the length of its longest valid prefix, at least 1
+static bool __read_sequence(const unsigned char* const s, const std::size_t n, const std::size_t i, std::size_t& length)
+{
+    const unsigned char c = s[i];
+    std::size_t expected;
+    unsigned char low = 0x80, high = 0xBF;
+    length = 1;
+    if(c < 0x80)
+        return true;
+    else if(c >= 0xC2 && c <= 0xDF)
+        expected = 2;
+    else if(c == 0xE0)
+        expected = 3, low = 0xA0;
+    else if(c == 0xED)
+        expected = 3, high = 0x9F;
+    else if(c >= 0xE1 && c <= 0xEF)
+        expected = 3;
+    else if(c == 0xF0)
+        expected = 4, low = 0x90;
+    else if(c == 0xF4)
+        expected = 4, high = 0x8F;
+    else if(c >= 0xF1 && c <= 0xF3)
+        expected = 4;
+    else
+        return false;
+
+    for(std::size_t k = 1; k < expected; k++, low = 0x80, high = 0xBF)
+    {
+        if(i + k >= n || s[i + k] < low || s[i + k] > high)
+            return false;
+        length++;
+    }
+    return true;
+}
+static std::size_t __find_invalid_scalar(const unsigned char* const s, const std::size_t n, std::size_t i)
+{
+    std::uint64_t word;
+    std::size_t length;
+    while(i < n)
+    {
+        // runs of ASCII eight octets at a time
+        for(; i + 8 <= n; i += 8)
+        {
+            std::memcpy(&word, s + i, 8);
+            if(word & 0x8080808080808080ull)
+                break;
+        }
+        if(i >= n)
+            break;
+        if(s[i] < 0x80)
+        {
+            i++;
+            continue;
+        }
+        if(!__read_sequence(s, n, i, length))
+            return i;
+        i += length;
+    }
+    return n;
+}
+#ifdef NNWCLI_UTF8_X86
+/**
+ * The lookup table algorithm of Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+ * Every pair of consecutive octets is classified by three table lookups, by the high and the low nibble
+ * of the first one and by the high nibble of the second one, each giving the set of errors the pair may be;
+ * their intersection is empty for the valid pairs. The third and fourth octets of the longer sequences
+ * are checked against the octets two and three positions before them.
+ * */
+static constexpr unsigned char __TOO_SHORT = 1 << 0;
+static constexpr unsigned char __TOO_LONG = 1 << 1;
+static constexpr unsigned char __OVERLONG_3 = 1 << 2;
+static constexpr unsigned char __TOO_LARGE = 1 << 3;
+static constexpr unsigned char __SURROGATE = 1 << 4;
+static constexpr unsigned char __OVERLONG_2 = 1 << 5;
+static constexpr unsigned char __TOO_LARGE_1000 = 1 << 6;
+static constexpr unsigned char __OVERLONG_4 = 1 << 6;
+static constexpr unsigned char __TWO_CONTS = 1 << 7;
+static constexpr unsigned char __CARRY = __TOO_SHORT | __TOO_LONG | __TWO_CONTS;
+
+alignas(16) static constexpr unsigned char __byte_1_high[16] = {
+    // ASCII
+    __TOO_LONG, __TOO_LONG, __TOO_LONG, __TOO_LONG,
+    __TOO_LONG, __TOO_LONG, __TOO_LONG, __TOO_LONG,
+    // continuation
+    __TWO_CONTS, __TWO_CONTS, __TWO_CONTS, __TWO_CONTS,
+    // 1100____, 1101____
+    __TOO_SHORT | __OVERLONG_2,
+    __TOO_SHORT,
+    // 1110____
+    __TOO_SHORT | __OVERLONG_3 | __SURROGATE,
+    // 1111____
+    __TOO_SHORT | __TOO_LARGE | __TOO_LARGE_1000 | __OVERLONG_4};
+alignas(16) static constexpr unsigned char __byte_1_low[16] = {
+    // ____0000
+    __CARRY | __OVERLONG_3 | __OVERLONG_2 | __OVERLONG_4,
+    // ____0001
+    __CARRY | __OVERLONG_2,
+    // ____001_
+    __CARRY,
+    __CARRY,
+    // ____0100
+    __CARRY | __TOO_LARGE,
+    // ____0101, ____011_
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    // ____1___
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    // ____1101
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000 | __SURROGATE,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000,
+    __CARRY | __TOO_LARGE | __TOO_LARGE_1000};
+alignas(16) static constexpr unsigned char __byte_2_high[16] = {
+    // ASCII
+    __TOO_SHORT, __TOO_SHORT, __TOO_SHORT, __TOO_SHORT,
+    __TOO_SHORT, __TOO_SHORT, __TOO_SHORT, __TOO_SHORT,
+    // 1000____
+    __TOO_LONG | __OVERLONG_2 | __TWO_CONTS | __OVERLONG_3 | __TOO_LARGE_1000 | __OVERLONG_4,
+    // 1001____
+    __TOO_LONG | __OVERLONG_2 | __TWO_CONTS | __OVERLONG_3 | __TOO_LARGE,
+    // 101_____
+    __TOO_LONG | __OVERLONG_2 | __TWO_CONTS | __SURROGATE | __TOO_LARGE,
+    __TOO_LONG | __OVERLONG_2 | __TWO_CONTS | __SURROGATE | __TOO_LARGE,
+    // 11______
+    __TOO_SHORT, __TOO_SHORT, __TOO_SHORT, __TOO_SHORT};
+// octets which begin a sequence longer than what is left of the block
+alignas(32) static constexpr unsigned char __incomplete_max[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+// where the scalar check has to start so that it sees the sequence which may continue into the block at start
+static std::size_t __resync(const unsigned char* const s, const std::size_t start)
+{
+    for(std::size_t k = 1; k <= 3 && k <= start; k++)
+    {
+        const unsigned char c = s[start - k];
+        if(c < 0x80)
+            break;
+        if(c >= 0xC0)
+        {
+            const std::size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+            return length > k ? start - k : start;
+        }
+    }
+    return start;
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i __check_block_ssse3(const __m128i input, const __m128i prev_input)
+{
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    const __m128i byte_1_high = _mm_shuffle_epi8(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(__byte_1_high)),
+            _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+    const __m128i byte_1_low = _mm_shuffle_epi8(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(__byte_1_low)),
+            _mm_and_si128(prev1, low_nibble));
+    const __m128i byte_2_high = _mm_shuffle_epi8(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(__byte_2_high)),
+            _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+    const __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // only 111_____ two octets before and 1111____ three octets before are at least 0x80 after subtraction
+    const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    const __m128i must_be_continuation = _mm_and_si128(
+            _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                         _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)))),
+            _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must_be_continuation, special_cases);
+}
+__attribute__((target("ssse3")))
+static std::size_t __find_invalid_block_ssse3(const unsigned char* const s, const std::size_t n)
+{
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    const __m128i incomplete_max = _mm_loadu_si128(reinterpret_cast<const __m128i*>(__incomplete_max + 16));
+    alignas(16) unsigned char tail[16];
+    std::size_t i = 0;
+    for(;; i += 16)
+    {
+        const bool last = i + 16 > n;
+        __m128i input;
+        if(!last)
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        else
+        {
+            // the rest is padded with ASCII, which ends the sequences still expecting continuations
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, s + i, n - i);
+            input = _mm_load_si128(reinterpret_cast<const __m128i*>(tail));
+        }
+
+        __m128i error;
+        if(!_mm_movemask_epi8(input))
+            error = prev_incomplete;
+        else
+        {
+            error = __check_block_ssse3(input, prev_input);
+            prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+            prev_input = input;
+        }
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF)
+            return __resync(s, i);
+        if(last)
+            return n;
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i __check_block_avx2(const __m256i input, const __m256i prev_input)
+{
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    // the octets before the block, shifted across the lanes
+    const __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+    const __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    const __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+    const __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+    const __m256i byte_1_high = _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(__byte_1_high))),
+            _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+    const __m256i byte_1_low = _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(__byte_1_low))),
+            _mm256_and_si256(prev1, low_nibble));
+    const __m256i byte_2_high = _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(__byte_2_high))),
+            _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+    const __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    const __m256i must_be_continuation = _mm256_and_si256(
+            _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                            _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)))),
+            _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+__attribute__((target("avx2")))
+static std::size_t __find_invalid_block_avx2(const unsigned char* const s, const std::size_t n)
+{
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    const __m256i incomplete_max = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(__incomplete_max));
+    alignas(32) unsigned char tail[32];
+    std::size_t i = 0;
+    for(;; i += 32)
+    {
+        const bool last = i + 32 > n;
+        __m256i input;
+        if(!last)
+            input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        else
+        {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, s + i, n - i);
+            input = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+        }
+
+        __m256i error;
+        if(!_mm256_movemask_epi8(input))
+            error = prev_incomplete;
+        else
+        {
+            error = __check_block_avx2(input, prev_input);
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+            prev_input = input;
+        }
+        if(!_mm256_testz_si256(error, error))
+            return __resync(s, i);
+        if(last)
+            return n;
+    }
+}
+
+static std::size_t __find_invalid_block_scalar(const unsigned char* const s, const std::size_t n)
+{
+    return __find_invalid_scalar(s, n, 0);
+}
+using __FindInvalidBlock = std::size_t (*)(const unsigned char*, std::size_t);
+static __FindInvalidBlock __pick_find_invalid_block()
+{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return __find_invalid_block_avx2;
+    if(__builtin_cpu_supports("ssse3"))
+        return __find_invalid_block_ssse3;
+    return __find_invalid_block_scalar;
+}
+#endif
+
+/**
+ * n when the whole buffer is valid, otherwise an offset not after the first invalid sequence,
+ * from which the scalar check finds it. Lines shorter than a block aren't worth the dispatch.
+ * */
+static std::size_t __find_invalid_block(const unsigned char* const s, const std::size_t n)
+{
+#ifdef NNWCLI_UTF8_X86
+    static const __FindInvalidBlock find_invalid_block = __pick_find_invalid_block();
+    if(n >= 16)
+        return find_invalid_block(s, n);
+#endif
+    return __find_invalid_scalar(s, n, 0);
+}
+
+bool nnwcli::utf8_validate(const char* const in, const std::size_t n)
+{
+    return __find_invalid_block(reinterpret_cast<const unsigned char*>(in), n) == n;
+}
+bool nnwcli::utf8_validate(const std::string_view in)
+{
+    return utf8_validate(in.data(), in.size());
+}
+std::size_t nnwcli::utf8_find_invalid(const char* const in, const std::size_t n)
+{
+    const unsigned char* const s = reinterpret_cast<const unsigned char*>(in);
+    const std::size_t start = __find_invalid_block(s, n);
+    if(start == n)
+        return n;
+    return __find_invalid_scalar(s, n, start);
+}
+std::size_t nnwcli::utf8_replace_invalid(std::string& str)
+{
+    std::size_t i = utf8_find_invalid(str.data(), str.size());
+    if(i == str.size())
+        return 0;
+
+    static const char replacement[] = "\xEF\xBF\xBD";
+    const unsigned char* const s = reinterpret_cast<const unsigned char*>(str.data());
+    const std::size_t n = str.size();
+    std::string out;
+    out.reserve(n + n / 2);
+    out.append(str, 0, i);
+    std::size_t count = 0;
+    std::size_t length;
+    while(i < n)
+    {
+        // invalid sequence at i
+        __read_sequence(s, n, i, length);
+        out.append(replacement, 3);
+        count++;
+        i += length;
+
+        const std::size_t next = __find_invalid_scalar(s, n, i);
+        out.append(str, i, next - i);
+        i = next;
+    }
+    str = std::move(out);
+    return count;
+}
+bool nnwcli::utf8_apply_policy(std::string& str, const EncodingPolicy policy)
+{
+    switch(policy)
+    {
+    case EP_REJECT:
+        return utf8_validate(str.data(), str.size());
+    case EP_REPLACE:
+        utf8_replace_invalid(str);
+        return true;
+    default:
+        return true;
+    }
+}
+
+
+// transcoding
+
+std::size_t nnwcli::utf8_count_octets(const std::string& in)
+{
+    return utf8_count_codepoints(in.data(), in.size());
+}
+std::size_t nnwcli::utf8_count_codepoints(const char* const in, const std::size_t n)
+{
+    std::size_t continuations = 0;
+    std::size_t i = 0;
+#ifdef NNWCLI_UTF8_SSE2
+    // continuation octets are the signed ones below -64
+    const __m128i continuation_max = _mm_set1_epi8(-65 + 1);
+    for(; i + 16 <= n; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        continuations += std::bitset<16>(_mm_movemask_epi8(_mm_cmplt_epi8(chunk, continuation_max))).count();
+    }
+#endif
+    for(; i < n; i++)
+    {
+        if((static_cast<unsigned char>(in[i]) & 0xC0) == 0x80)
+            continuations++;
+    }
+    return n - continuations;
+}
+std::size_t nnwcli::utf8_count_codepoints(const std::string_view in)
+{
+    return utf8_count_codepoints(in.data(), in.size());
+}
+
+// value of the valid sequence of length octets
+static char32_t __sequence_value(const unsigned char* const s, const std::size_t length)
+{
+    switch(length)
+    {
+    case 1:
+        return s[0];
+    case 2:
+        return ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+    case 3:
+        return ((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+    default:
+        return ((s[0] & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+    }
+}
+std::size_t nnwcli::utf8_decode(const char* const in, const std::size_t n, char32_t& out)
+{
+    const unsigned char* const s = reinterpret_cast<const unsigned char*>(in);
+    std::size_t length;
+
+    out = __read_sequence(s, n, 0, length) ? __sequence_value(s, length) : 0xFFFD;
+    return length;
+}
+// octets of the valid code point written into out
+static std::size_t __encode(char* const out, const char32_t value)
+{
+    if(value < 0x80)
+    {
+        out[0] = value;
+        return 1;
+    }
+    if(value < 0x800)
+    {
+        out[0] = 0xC0 | (value >> 6);
+        out[1] = 0x80 | (value & 0x3F);
+        return 2;
+    }
+    if(value < 0x10000)
+    {
+        out[0] = 0xE0 | (value >> 12);
+        out[1] = 0x80 | ((value >> 6) & 0x3F);
+        out[2] = 0x80 | (value & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | (value >> 18);
+    out[1] = 0x80 | ((value >> 12) & 0x3F);
+    out[2] = 0x80 | ((value >> 6) & 0x3F);
+    out[3] = 0x80 | (value & 0x3F);
+    return 4;
+}
+
+void nnwcli::utf8_to_utf32(const std::string_view in, std::u32string& out)
+{
+    const unsigned char* const s = reinterpret_cast<const unsigned char*>(in.data());
+    const std::size_t n = in.size();
+    std::size_t i = 0, written = 0, length;
+
+    // every octet is a code point at most
+    out.resize(n);
+    char32_t* const dst = out.data();
+    while(i < n)
+    {
+#ifdef NNWCLI_UTF8_SSE2
+        // runs of ASCII are widened 16 octets at a time
+        const __m128i zero = _mm_setzero_si128();
+        for(; i + 16 <= n; i += 16, written += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if(_mm_movemask_epi8(chunk))
+                break;
+            const __m128i low = _mm_unpacklo_epi8(chunk, zero);
+            const __m128i high = _mm_unpackhi_epi8(chunk, zero);
+            __m128i* const target = reinterpret_cast<__m128i*>(dst + written);
+            _mm_storeu_si128(target, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(target + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(target + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(target + 3, _mm_unpackhi_epi16(high, zero));
+        }
+        if(i >= n)
+            break;
+#endif
+        if(s[i] < 0x80)
+        {
+            dst[written++] = s[i++];
+            continue;
+        }
+        if(!__read_sequence(s, n, i, length))
+            throw std::invalid_argument("invalid UTF-8");
+        dst[written++] = __sequence_value(s + i, length);
+        i += length;
+    }
+    out.resize(written);
+}
+void nnwcli::utf32_to_utf8(const std::u32string_view in, std::string& out)
+{
+    const char32_t* const src = in.data();
+    const std::size_t n = in.size();
+    std::size_t i = 0, written = 0;
+
+    out.resize(n * 4);
+    char* const dst = out.data();
+    while(i < n)
+    {
+#ifdef NNWCLI_UTF8_SSE2
+        // 16 ASCII code points are narrowed at once, the signed saturation keeps them as they are
+        for(; i + 16 <= n; i += 16, written += 16)
+        {
+            const __m128i* const source = reinterpret_cast<const __m128i*>(src + i);
+            const __m128i a = _mm_loadu_si128(source);
+            const __m128i b = _mm_loadu_si128(source + 1);
+            const __m128i c = _mm_loadu_si128(source + 2);
+            const __m128i d = _mm_loadu_si128(source + 3);
+            const __m128i above_ascii = _mm_andnot_si128(_mm_set1_epi32(0x7F),
+                    _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)));
+            if(_mm_movemask_epi8(_mm_cmpeq_epi8(above_ascii, _mm_setzero_si128())) != 0xFFFF)
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + written),
+                    _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+        if(i >= n)
+            break;
+#endif
+        const char32_t value = src[i++];
+        if(value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF))
+            throw std::invalid_argument("invalid code point");
+        written += __encode(dst + written, value);
+    }
+    out.resize(written);
+}
+void nnwcli::utf8_to_utf16(const std::string_view in, std::u16string& out)
+{
+    const unsigned char* const s = reinterpret_cast<const unsigned char*>(in.data());
+    const std::size_t n = in.size();
+    std::size_t i = 0, written = 0, length;
+
+    // the four octet sequences become two units, the others one
+    out.resize(n);
+    char16_t* const dst = out.data();
+    while(i < n)
+    {
+#ifdef NNWCLI_UTF8_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for(; i + 16 <= n; i += 16, written += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if(_mm_movemask_epi8(chunk))
+                break;
+            __m128i* const target = reinterpret_cast<__m128i*>(dst + written);
+            _mm_storeu_si128(target, _mm_unpacklo_epi8(chunk, zero));
+            _mm_storeu_si128(target + 1, _mm_unpackhi_epi8(chunk, zero));
+        }
+        if(i >= n)
+            break;
+#endif
+        if(s[i] < 0x80)
+        {
+            dst[written++] = s[i++];
+            continue;
+        }
+        if(!__read_sequence(s, n, i, length))
+            throw std::invalid_argument("invalid UTF-8");
+        const char32_t value = __sequence_value(s + i, length);
+        if(value >= 0x10000)
+        {
+            dst[written++] = 0xD800 + ((value - 0x10000) >> 10);
+            dst[written++] = 0xDC00 + ((value - 0x10000) & 0x3FF);
+        }
+        else
+            dst[written++] = value;
+        i += length;
+    }
+    out.resize(written);
+}
+void nnwcli::utf16_to_utf8(const std::u16string_view in, std::string& out)
+{
+    const char16_t* const src = in.data();
+    const std::size_t n = in.size();
+    std::size_t i = 0, written = 0;
+
+    // three octets per unit at most, the surrogate pairs take four for two units
+    out.resize(n * 3);
+    char* const dst = out.data();
+    while(i < n)
+    {
+#ifdef NNWCLI_UTF8_SSE2
+        for(; i + 16 <= n; i += 16, written += 16)
+        {
+            const __m128i* const source = reinterpret_cast<const __m128i*>(src + i);
+            const __m128i a = _mm_loadu_si128(source);
+            const __m128i b = _mm_loadu_si128(source + 1);
+            const __m128i above_ascii = _mm_andnot_si128(_mm_set1_epi16(0x7F), _mm_or_si128(a, b));
+            if(_mm_movemask_epi8(_mm_cmpeq_epi8(above_ascii, _mm_setzero_si128())) != 0xFFFF)
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + written), _mm_packus_epi16(a, b));
+        }
+        if(i >= n)
+            break;
+#endif
+        char32_t value = src[i++];
+        if(value >= 0xD800 && value <= 0xDFFF)
+        {
+            // a high surrogate followed by a low one
+            if(value > 0xDBFF || i >= n || src[i] < 0xDC00 || src[i] > 0xDFFF)
+                throw std::invalid_argument("unpaired surrogate");
+            value = 0x10000 + ((value - 0xD800) << 10) + (src[i++] - 0xDC00);
+        }
+        written += __encode(dst + written, value);
+    }
+    out.resize(written);
+}
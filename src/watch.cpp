@@ -0,0 +1,189 @@
+/**
+ * watch.cpp - Periodic re-execution of a command, sending only what has changed in its output.
+ *
+ * License: The MIT License.
+ * Copyright 2025 dernisnw@neonw.su
+ * */
+
+
+#include "watch.hpp"
+#include <utility>
+
+using namespace nnwcli;
+
+
+static void __split_lines(const std::string_view text, std::vector<std::string_view>& lines)
+{
+    std::size_t start = 0;
+
+    lines.clear();
+    while(start < text.size())
+    {
+        std::size_t end = text.find('\n', start);
+        if(end == std::string_view::npos)
+            end = text.size();
+        lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+}
+// FNV-1a, enough to tell whether a chunk has changed
+static std::uint64_t __hash(const std::string_view data)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+
+    for(const char c : data)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+CommandWatch::CommandWatch(CommandExecutor& executor, std::string line,
+        std::shared_ptr<CommandExecutorContext> target, const std::chrono::milliseconds interval,
+        const WatchDiffMode mode, const std::size_t chunk_size) :
+    m_executor(executor), m_line(std::move(line)), m_target(std::move(target)), m_interval(interval),
+    m_mode(mode), m_chunk_size(chunk_size ? chunk_size : 1), m_capture(std::make_shared<CaptureContext>()),
+    m_previous(counting_memory_resource()), m_first(true), m_runs(0), m_changes(0), m_stopping(false), m_running(false) {}
+
+CommandWatch::~CommandWatch()
+{
+    stop();
+}
+void CommandWatch::start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_thread.joinable())
+    {
+        if(m_running)
+            return;
+        // it has stopped by itself and doesn't need the lock anymore
+        m_thread.join();
+    }
+    m_stopping = false;
+    m_running = true;
+    m_error = nullptr;
+    m_thread = std::thread([this]()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while(!m_stopping)
+        {
+            lock.unlock();
+            try
+            {
+                run_once();
+            }
+            catch(...)
+            {
+                // the target can't take the output anymore
+                lock.lock();
+                m_error = std::current_exception();
+                break;
+            }
+            lock.lock();
+            m_condition.wait_for(lock, m_interval, [this]() { return m_stopping; });
+        }
+        m_running = false;
+    });
+}
+void CommandWatch::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    if(m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+        m_thread.join();
+}
+void CommandWatch::_diff_lines(const std::string_view current)
+{
+    std::vector<std::string_view> previous_lines, current_lines;
+
+    __split_lines(m_previous, previous_lines);
+    __split_lines(current, current_lines);
+    for(std::size_t i = 0; i < current_lines.size(); i++)
+    {
+        if(m_first || i >= previous_lines.size() || previous_lines[i] != current_lines[i])
+            m_target->begin_record("line").field("index", i).field("text", current_lines[i]).end_record();
+    }
+    if(m_first || current_lines.size() != previous_lines.size())
+        m_target->begin_record("lines").field("count", current_lines.size()).end_record();
+}
+void CommandWatch::_diff_chunks(const std::string_view current)
+{
+    const std::size_t count = (current.size() + m_chunk_size - 1) / m_chunk_size;
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const std::string_view chunk = current.substr(i * m_chunk_size, m_chunk_size);
+        const std::uint64_t hash = __hash(chunk);
+
+        if(m_first || i >= m_previous_hashes.size() || m_previous_hashes[i] != hash)
+            m_target->begin_record("chunk").field("offset", i * m_chunk_size).field("data", chunk).end_record();
+        if(i < m_previous_hashes.size())
+            m_previous_hashes[i] = hash;
+        else
+            m_previous_hashes.push_back(hash);
+    }
+    m_previous_hashes.resize(count);
+    if(m_first || current.size() != m_previous.size())
+        m_target->begin_record("size").field("size", current.size()).end_record();
+}
+DispatchResult CommandWatch::run_once()
+{
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+
+    m_capture->reset();
+    const DispatchResult result = m_executor.dispatch_line_detailed(m_line, m_capture);
+    // taken from the same memory resource as m_previous, so it is moved into it without a copy
+    std::pmr::string current = m_capture->take();
+
+    if(m_first || current != m_previous)
+    {
+        m_target->begin_dispatch();
+        try
+        {
+            if(m_mode == WD_CHUNKS)
+                _diff_chunks(current);
+            else
+                _diff_lines(current);
+        }
+        catch(...)
+        {
+            m_target->end_dispatch();
+            throw;
+        }
+        m_target->end_dispatch();
+        m_changes++;
+    }
+    m_previous = std::move(current);
+    m_first = false;
+    m_runs++;
+    return result;
+}
+std::exception_ptr CommandWatch::get_error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error;
+}
+bool CommandWatch::is_running() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+const std::string& CommandWatch::get_line() const
+{
+    return m_line;
+}
+std::uint64_t CommandWatch::get_runs() const
+{
+    return m_runs;
+}
+std::uint64_t CommandWatch::get_changes() const
+{
+    return m_changes;
+}